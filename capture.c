@@ -0,0 +1,117 @@
+#include "capture.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>          // Dla open()
+#include <unistd.h>         // Dla ftruncate() i close()
+#include <sys/mman.h>       // Dla mmap()/munmap()
+#include <time.h>           // Dla clock_gettime()
+
+// Stan otwartego zapisu - jeden na proces
+static int capture_fd = -1;
+static char* capture_map = NULL;    // Zmapowany plik
+static size_t capture_size = 0;     // Aktualny rozmiar pliku i mapowania
+
+// Funkcja mapująca plik o rozmiarze new_size (po wcześniejszym ftruncate)
+static int capture_remap(size_t new_size) {
+    if (capture_map != NULL) {
+        munmap(capture_map, capture_size);
+        capture_map = NULL;
+    }
+
+    if (ftruncate(capture_fd, new_size) < 0) {
+        perror("Błąd zapisu ruchu: ftruncate");
+        return -1;
+    }
+
+    void* mapped = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, capture_fd, 0);
+    if (mapped == MAP_FAILED) {
+        perror("Błąd zapisu ruchu: mmap");
+        return -1;
+    }
+
+    capture_map = (char*)mapped;
+    capture_size = new_size;
+    return 0;
+}
+
+int capture_open(const char* path, char role) {
+    capture_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (capture_fd < 0) {
+        perror("Błąd zapisu ruchu");
+        return -1;
+    }
+
+    if (capture_remap(CAPTURE_GROW_SIZE) < 0) {
+        close(capture_fd);
+        capture_fd = -1;
+        return -1;
+    }
+
+    struct CaptureHeader* header = (struct CaptureHeader*)capture_map;
+    memset(header, 0, sizeof(*header));
+    header->magic = CAPTURE_MAGIC;
+    header->version = CAPTURE_VERSION;
+    header->role = role;
+    header->used = sizeof(struct CaptureHeader);
+
+    printf("\033[33mZapis ruchu do pliku: %s\033[0m\n", path);
+    return 0;
+}
+
+void capture_record(char direction, const struct sockaddr_in* peer, const char* data, size_t length) {
+    if (capture_map == NULL) {
+        return;
+    }
+
+    struct CaptureHeader* header = (struct CaptureHeader*)capture_map;
+    size_t record_size = CAPTURE_RECORD_SIZE(length);
+
+    // Brak miejsca - powiększenie pliku o wielokrotność CAPTURE_GROW_SIZE
+    if (header->used + record_size > capture_size) {
+        size_t new_size = capture_size + CAPTURE_GROW_SIZE;
+        while (header->used + record_size > new_size) {
+            new_size += CAPTURE_GROW_SIZE;
+        }
+        if (capture_remap(new_size) < 0) {
+            capture_close();
+            return;
+        }
+        header = (struct CaptureHeader*)capture_map;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    struct CaptureRecord* record = (struct CaptureRecord*)(capture_map + header->used);
+    memset(record, 0, sizeof(*record));
+    record->timestamp_ns = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+    record->peer_addr = peer->sin_addr.s_addr;
+    record->peer_port = peer->sin_port;
+    record->direction = direction;
+    record->length = length;
+    memcpy(record + 1, data, length);
+
+    // Licznik zajętości przesuwany na końcu - przerwany zapis nie psuje pliku
+    header->used += record_size;
+}
+
+void capture_close() {
+    if (capture_fd < 0) {
+        return;
+    }
+
+    size_t used = capture_size;
+    if (capture_map != NULL) {
+        used = ((struct CaptureHeader*)capture_map)->used;
+        munmap(capture_map, capture_size);
+        capture_map = NULL;
+    }
+
+    // Obcięcie zapasu dodanego przy powiększaniu pliku
+    if (ftruncate(capture_fd, used) < 0) {
+        perror("Błąd zapisu ruchu: ftruncate");
+    }
+    close(capture_fd);
+    capture_fd = -1;
+}
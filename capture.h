@@ -0,0 +1,59 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>     // Dla struct sockaddr_in
+
+// Binarny zapis ruchu protokołu - plik tylko do dopisywania, mapowany do pamięci.
+// Używany przez serwer i klienta (zapis) oraz przez replay (odtwarzanie).
+//
+// Układ pliku:
+//   struct CaptureHeader
+//   struct CaptureRecord + length bajtów danych (dopełnione do 8 bajtów)
+//   struct CaptureRecord + ...
+
+#define CAPTURE_MAGIC 0x50414354u       // "TCAP" w kolejności little-endian
+#define CAPTURE_VERSION 1
+#define CAPTURE_GROW_SIZE (1024 * 1024) // O ile powiększany jest plik, gdy brakuje miejsca
+#define CAPTURE_ALIGN 8                 // Wyrównanie kolejnych rekordów
+
+// Kierunek datagramu z punktu widzenia programu zapisującego
+#define CAPTURE_IN 'r'      // Datagram odebrany
+#define CAPTURE_OUT 's'     // Datagram wysłany
+
+// Rola programu, który utworzył zapis
+#define CAPTURE_ROLE_SERVER 's'
+#define CAPTURE_ROLE_CLIENT 'c'
+
+struct CaptureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t role;           // CAPTURE_ROLE_SERVER / CAPTURE_ROLE_CLIENT
+    uint8_t reserved[7];
+    uint64_t used;          // Zajęte bajty (nagłówek + rekordy) - aktualizowane po każdym rekordzie
+};
+
+struct CaptureRecord {
+    uint64_t timestamp_ns;  // Czas CLOCK_MONOTONIC w nanosekundach
+    uint32_t peer_addr;     // Adres IPv4 drugiej strony (kolejność sieciowa)
+    uint32_t length;        // Liczba bajtów danych za rekordem
+    uint16_t peer_port;     // Port drugiej strony (kolejność sieciowa)
+    uint8_t direction;      // CAPTURE_IN / CAPTURE_OUT
+    uint8_t reserved[5];
+};
+
+// Rozmiar rekordu razem z danymi i dopełnieniem
+#define CAPTURE_RECORD_SIZE(length) \
+    ((sizeof(struct CaptureRecord) + (length) + CAPTURE_ALIGN - 1) & ~(size_t)(CAPTURE_ALIGN - 1))
+
+// Otwiera (tworzy lub obcina) plik zapisu. Zwraca 0 albo -1 przy błędzie.
+int capture_open(const char* path, char role);
+
+// Dopisuje datagram do zapisu. Nic nie robi, gdy zapis nie jest otwarty.
+void capture_record(char direction, const struct sockaddr_in* peer, const char* data, size_t length);
+
+// Obcina plik do zajętego rozmiaru i zamyka zapis
+void capture_close();
+
+#endif
@@ -6,16 +6,31 @@
 #include <unistd.h>         // Dla funkcji close() i sleep()
 #include <time.h>           // Dla funkcji time() - obsługa czasu
 #include <sys/time.h>       // Dla funkcji gettimeofday() - precyzyjny pomiar czasu
+#include <stdint.h>         // Dla uint32_t (licznik SO_RXQ_OVFL)
+#include <stdatomic.h>      // Dla atomowych pól rejestru serwerów (seqlock, liveness)
+#include <fcntl.h>          // Dla open() - plik migawki rejestru
+#include <sys/mman.h>       // Dla mmap()/msync() - migawka rejestru w pamięci
+#include <sys/stat.h>       // Dla fstat() - rozmiar pliku migawki
+#include <stddef.h>         // Dla offsetof() - opis kluczy konfiguracji
+#include <errno.h>          // Dla errno (EINTR po sygnale przeładowania)
+
+#include "capture.h"        // Zapis ruchu do pliku (tryb przechwytywania)
+#include "pool.h"           // Pula buforów wiadomości zamiast malloc()/free()
+#include "parse.h"          // Wektorowa walidacja i klasyfikacja odebranych wiadomości
+#include "config.h"         // Plik konfiguracyjny i przeładowanie po SIGHUP
+#include "udp.h"            // Bufory gniazda, licznik SO_RXQ_OVFL, send_datagram()
+#include "frame.h"          // Ramki zbiorcze - kilka wiadomości w jednym datagramie
+#include "registry.h"       // Rejestr serwerów bez blokad (seqlock, słowo liveness)
+#include "signals.h"        // Zakończenie przez SIGINT/SIGTERM z zapisem migawki i zapisu ruchu
 
 // Stałe konfiguracyjne
 #define CLIENT_PORT 1305    // Port nasłuchiwania klienta
 #define BUFFER_SIZE 1024    // Rozmiar bufora na wiadomości
 #define PING_MESSAGE_LEN 13 // Długość wiadomości PING wysyłanej do serwera
-#define MAX_SERVERS 10      // Maksymalna liczba serwerów w tablicy
-
-#define MAX_IP_LENGTH 16    // Maksymalna długość adresu IP (format XXX.XXX.XXX.XXX\0)
-#define UP 1               // Status serwera - aktywny
-#define DOWN 0             // Status serwera - nieaktywny
+#define PACKET_POOL_SLAB 64 // Liczba buforów wiadomości w jednej płycie puli
+#define CLIENT_CONFIG_PATH "client.conf"  // Plik konfiguracyjny (katalog roboczy)
+#define PING_INTERVAL_MIN_MS 1500   // Najkrótszy losowy odstęp między PINGami
+#define PING_INTERVAL_MAX_MS 2550   // Najdłuższy losowy odstęp między PINGami
 
 // Nagłówki protokołu komunikacyjnego
 #define HELLO 'h'    // Wiadomość powitalna
@@ -23,92 +38,233 @@
 #define PONG 'o'     // Odpowiedź na ping
 #define REQUEST 'q'  // Sprawdzenie aktywności
 #define RESPONSE 's' // Potwierdzenie aktywności
-
-#define REQUEST_INTERVAL 0.27  // Interwał sprawdzania aktywności (270ms)
+#define PACKED 'p'   // Ramka zbiorcza z kilkoma wiadomościami
+
+// Ramki zbiorcze (frame.h) - kilka wiadomości (PING, REQUEST) do jednego serwera w jednym datagramie.
+// Włączane kluczem packed_frames w client.conf albo przy kompilacji: make CFLAGS="-DPACKED_FRAMES=1"
+#ifndef PACKED_FRAMES
+#define PACKED_FRAMES 0
+#endif
+#ifndef PACK_FLUSH_DEADLINE_MS
+#define PACK_FLUSH_DEADLINE_MS 2    // Maksymalny czas oczekiwania wiadomości w ramce
+#endif
+
+#define REQUEST_INTERVAL_MS 270 // Interwał sprawdzania aktywności
+                               // Serwer, od którego w tym czasie przyszedł dowolny pakiet
+                               // (HELLO, PONG, RESPONSE), nie dostaje osobnego REQUEST
 #define MAX_REQUEST_ATTEMPTS 3 // Maksymalna liczba prób przed uznaniem serwera za nieaktywny
 
+// Migawka rejestru serwerów - plik mapowany do pamięci, dzięki któremu klient po
+// restarcie od razu zna serwery zamiast czekać na ich HELLO (do 5 s)
+#define SNAPSHOT_PATH "client_registry.snap"
+#define SNAPSHOT_MAGIC 0x50414E53u   // "SNAP" w kolejności little-endian
+#define SNAPSHOT_VERSION 5
+#define SNAPSHOT_SYNC_INTERVAL 1     // Co ile sekund zlecać zapis zmienionych stron (msync)
+#define RTT_SMOOTHING 0.125          // Waga nowej próbki w wygładzonym RTT (jak SRTT w TCP)
+
+// Bufory gniazda - 0 oznacza domyślną wartość jądra (net.core.rmem_default/wmem_default)
+#ifndef SOCKET_RCVBUF
+#define SOCKET_RCVBUF 0
+#endif
+#ifndef SOCKET_SNDBUF
+#define SOCKET_SNDBUF 0
+#endif
+
 // Zmienna do inicjalizacji generatora liczb losowych
 static int seeded = 0;
 
-// Struktura przechowująca informacje o serwerze
-// Używa typów wbudowanych w C do śledzenia stanu serwera
-struct ServerInfo {
-    int id;                     // Identyfikator serwera
-    char ip[MAX_IP_LENGTH];     // Tablica znaków na adres IP (statyczna alokacja)
-    int port;                   // Numer portu
-    int status;                 // Status (UP/DOWN)
-    int failed_requests;        // Licznik nieudanych prób połączenia
-    time_t last_request_time;   // Znacznik czasu ostatniego żądania (sekundy)
-    long last_request_time_usec; // Mikrosekundy ostatniego żądania
-};
-
 // Struktura do śledzenia stanu ping-pong
 struct PingInfo {
     struct timeval start_time;   // Struktura czasu z sys/time.h
     int waiting_for_pong;       // Flag oczekiwania na odpowiedź
-} ping_state = {.waiting_for_pong = 0};  // Inicjalizacja zmiennej globalnej
+    int server_index;           // Indeks serwera, do którego wysłano PING
+} ping_state = {.waiting_for_pong = 0, .server_index = -1};  // Inicjalizacja zmiennej globalnej
+
+// Ostatnia wartość licznika SO_RXQ_OVFL (pakiety odrzucone przez jądro, skumulowane)
+static uint32_t kernel_drops = 0;
+// Liczba datagramów odrzuconych przez walidację (parse_classify)
+static unsigned long malformed_messages = 0;
+
+// Ramka czekająca na wysłanie do jednego serwera (indeks jak w tablicy servers)
+struct PendingFrame {
+    struct PackedFrame frame;
+    struct sockaddr_in addr;    // Adres serwera docelowego
+    struct timeval first_queued; // Czas dodania pierwszej wiadomości - od niego liczony termin
+} pending_frames[MAX_SERVERS];
+
+// Układ pliku migawki: nagłówek i tablica serwerów w tej samej postaci co w pamięci.
+// entry_size i max_servers chronią przed wczytaniem pliku z innej wersji binarki
+struct RegistrySnapshot {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_size;        // sizeof(struct ServerInfo)
+    uint32_t max_servers;       // MAX_SERVERS
+    int32_t server_count;       // Liczba zapisanych serwerów (zapisywana po wpisie)
+    struct ServerInfo entries[MAX_SERVERS];
+};
+
+// Rejestr serwerów - zmapowany plik migawki albo, gdy mapowanie się nie uda, pamięć statyczna
+static struct RegistrySnapshot registry_fallback;
+static struct RegistrySnapshot* registry = &registry_fallback;
+static int registry_mapped = 0;
+
+// Pula buforów na wiadomości (add_header, generate_random_string).
+// Wpisy rejestru nie potrzebują puli - leżą w stałej tablicy zmapowanej migawki
+struct Pool packet_pool;
+
+// Konfiguracja w czasie działania (plik CLIENT_CONFIG_PATH, przeładowanie po SIGHUP).
+// Stałe powyżej są wartościami domyślnymi; pojemności (MAX_SERVERS - układ migawki
+// i maska rundy, BUFFER_SIZE - bufory na stosie i w puli) pozostają stałymi kompilacji
+struct ClientConfig {
+    int client_port;                    // Port nasłuchiwania (tylko przy starcie - bind)
+    int request_interval_ms;            // Interwał rundy sprawdzania aktywności
+    int max_request_attempts;           // Próby przed uznaniem serwera za nieaktywny
+    int ping_interval_min_ms;           // Zakres losowego odstępu między PINGami
+    int ping_interval_max_ms;
+    int packed_frames;                  // 1 = ramki zbiorcze
+    int pack_flush_deadline_ms;         // Maksymalny czas oczekiwania wiadomości w ramce
+    int socket_rcvbuf;                  // SO_RCVBUF, 0 = domyślna wartość jądra
+    int socket_sndbuf;                  // SO_SNDBUF, 0 = domyślna wartość jądra
+    int snapshot_sync_interval;         // Co ile sekund msync() migawki rejestru
+};
+
+static const struct ClientConfig config_defaults = {
+    .client_port = CLIENT_PORT,
+    .request_interval_ms = REQUEST_INTERVAL_MS,
+    .max_request_attempts = MAX_REQUEST_ATTEMPTS,
+    .ping_interval_min_ms = PING_INTERVAL_MIN_MS,
+    .ping_interval_max_ms = PING_INTERVAL_MAX_MS,
+    .packed_frames = PACKED_FRAMES,
+    .pack_flush_deadline_ms = PACK_FLUSH_DEADLINE_MS,
+    .socket_rcvbuf = SOCKET_RCVBUF,
+    .socket_sndbuf = SOCKET_SNDBUF,
+    .snapshot_sync_interval = SNAPSHOT_SYNC_INTERVAL,
+};
 
-// Globalna tablica serwerów - pamięć alokowana statycznie
-struct ServerInfo servers[MAX_SERVERS];
-int server_count = 0;  // Licznik aktywnych serwerów
+static const struct ConfigOption config_options[] = {
+    {"client_port", CONFIG_INT, offsetof(struct ClientConfig, client_port), 1, 65535, 0},
+    {"request_interval_ms", CONFIG_INT, offsetof(struct ClientConfig, request_interval_ms), 10, 600000, 1},
+    {"max_request_attempts", CONFIG_INT, offsetof(struct ClientConfig, max_request_attempts), 1, 100, 1},
+    {"ping_interval_min_ms", CONFIG_INT, offsetof(struct ClientConfig, ping_interval_min_ms), 1, 3600000, 1},
+    {"ping_interval_max_ms", CONFIG_INT, offsetof(struct ClientConfig, ping_interval_max_ms), 1, 3600000, 1},
+    {"packed_frames", CONFIG_INT, offsetof(struct ClientConfig, packed_frames), 0, 1, 1},
+    {"pack_flush_deadline_ms", CONFIG_INT, offsetof(struct ClientConfig, pack_flush_deadline_ms), 0, 1000, 1},
+    {"socket_rcvbuf", CONFIG_INT, offsetof(struct ClientConfig, socket_rcvbuf), 0, 1 << 30, 1},
+    {"socket_sndbuf", CONFIG_INT, offsetof(struct ClientConfig, socket_sndbuf), 0, 1 << 30, 1},
+    {"snapshot_sync_interval", CONFIG_INT, offsetof(struct ClientConfig, snapshot_sync_interval), 0, 3600, 1},
+};
+
+// Funkcja sprawdzająca zależności między kluczami
+static int validate_config(const void* config) {
+    const struct ClientConfig* client_config = config;
+    if (client_config->ping_interval_min_ms > client_config->ping_interval_max_ms) {
+        printf("\033[31mping_interval_min_ms większy niż ping_interval_max_ms\033[0m\n");
+        return -1;
+    }
+    return 0;
+}
+
+static struct ConfigSet config_set = {
+    .path = CLIENT_CONFIG_PATH,
+    .options = config_options,
+    .option_count = sizeof(config_options) / sizeof(config_options[0]),
+    .defaults = &config_defaults,
+    .size = sizeof(struct ClientConfig),
+    .validate = validate_config,
+};
+
+// Bieżąca konfiguracja - pobierana przy każdym użyciu, bez przechowywania wskaźnika
+static inline const struct ClientConfig* current_config() {
+    return config_current(&config_set);
+}
 
 // Prototypy funkcji
 char* add_header(char* message, char header);
 char* process_header(char* message);
-void server_hello_handler(char* message, const char* ip, int port);
+void server_hello_handler(const char* message, int length, const char* ip, int port);
 char* generate_random_string(int length);
 void print_servers();
-void client_listen(int server_socket, struct sockaddr_in sender_addr, socklen_t client_len);
+void client_listen(int server_socket, struct sockaddr_in sender_addr);
+void configure_socket(int sock);
+int receive_datagram(int sock, char* buffer, size_t length, struct sockaddr_in* sender_addr);
+void queue_message(int sock, int server_index, const char* data, size_t length, struct sockaddr_in* addr);
 void init_random_generator_seed();
 void send_pings(int client_socket);
-int get_random_active_server();
+void snapshot_open();
+void snapshot_sync(int force);
 
 // Funkcja sprawdzająca aktywność serwerów
+// Co request_interval_ms rozpoczyna nową rundę (epokę) i wysyła REQUEST tylko do serwerów,
+// od których w tym czasie nie przyszedł żaden inny pakiet - dla pozostałych
+// aktywność potwierdził już ruch HELLO/PONG/RESPONSE
 void send_keep_alive_check(int client_socket) {
     struct timeval now;  // Struktura przechowująca aktualny czas
     gettimeofday(&now, NULL);  // Pobranie aktualnego czasu z mikrosekundami
     double current_time_ms = now.tv_sec + (now.tv_usec / 1000000.0);
+    double request_interval = current_config()->request_interval_ms / 1000.0;
+    int max_attempts = current_config()->max_request_attempts;
+
+    double time_since_round = current_time_ms -
+                              (probe_round.start_time.tv_sec +
+                               (probe_round.start_time.tv_usec / 1000000.0));
+    if(time_since_round < request_interval) {
+        return;
+    }
+
+    unsigned int unanswered = atomic_load(&probe_round.pending_probes);
+    if(unanswered != 0) {
+        printf("\033[33mBrak odpowiedzi w epoce %u od %d serwerów\033[0m\n",
+               atomic_load(&probe_round.epoch), __builtin_popcount(unanswered));
+    }
+
+    unsigned int epoch = atomic_fetch_add(&probe_round.epoch, 1) + 1;
+    atomic_store(&probe_round.pending_probes, 0);
+    probe_round.start_time = now;
+
+    // Kompaktowa wiadomość: nagłówek + numer epoki, np. "q42"
+    char request[16];
+    sprintf(request, "%c%u", REQUEST, epoch);
 
     // Iteracja po wszystkich serwerach
-    for(int i = 0; i < server_count; i++) {
-        if(servers[i].status == UP) {
-            // Obliczenie czasu od ostatniego sprawdzenia
-            double time_since_last = current_time_ms -
-                                   (servers[i].last_request_time +
-                                    (servers[i].last_request_time_usec / 1000000.0));
-
-            if(time_since_last >= REQUEST_INTERVAL) {
-                // Przygotowanie struktury adresu serwera
-                struct sockaddr_in server_addr;
-                memset(&server_addr, 0, sizeof(server_addr));  // Wyzerowanie pamięci struktury
-                server_addr.sin_family = AF_INET;
-                server_addr.sin_port = htons(servers[i].port);
-                inet_pton(AF_INET, servers[i].ip, &server_addr.sin_addr);
-
-                char request = REQUEST;
-                printf("\033[34mWysyłanie wiadomości: [%c]\033[0m\n", request);
-                sendto(client_socket,
-                      &request,
-                      1,
-                      0,
-                      (struct sockaddr*)&server_addr,
-                      sizeof(server_addr));
-
-                printf("\033[33mWysłano REQUEST do serwera %d (próba %d)\033[0m\n",
-                       servers[i].id, servers[i].failed_requests + 1);
-
-                servers[i].last_request_time = now.tv_sec;
-                servers[i].last_request_time_usec = now.tv_usec;
-                servers[i].failed_requests++;
-
-                if(servers[i].failed_requests >= MAX_REQUEST_ATTEMPTS) {
-                    printf("\033[31mSerwer %d nie odpowiada, oznaczanie jako DOWN\033[0m\n",
-                           servers[i].id);
-                    servers[i].status = DOWN;
-                    servers[i].failed_requests = 0;
-                    print_servers();
-                }
-            }
+    int count = atomic_load(&server_count);
+    for(int i = 0; i < count; i++) {
+        struct ServerInfo server;
+        registry_read(i, &server);
+        if(LIVENESS_STATUS(server.liveness) != UP) {
+            continue;
+        }
+
+        // Obliczenie czasu od ostatniego pakietu od serwera
+        double time_since_seen = current_time_ms -
+                               (server.last_seen +
+                                (server.last_seen_usec / 1000000.0));
+
+        if(time_since_seen < request_interval) {
+            continue;
+        }
+
+        // Przygotowanie struktury adresu serwera
+        struct sockaddr_in server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));  // Wyzerowanie pamięci struktury
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(server.liveness_port);
+        inet_pton(AF_INET, server.ip, &server_addr.sin_addr);
+
+        printf("\033[34mWysyłanie wiadomości: %s\033[0m\n", request);
+        queue_message(client_socket, i, request, strlen(request), &server_addr);
+
+        atomic_fetch_or(&probe_round.pending_probes, 1u << i);
+        int attempts;
+        int marked_down = record_failed_request(i, max_attempts, &attempts);
+
+        printf("\033[33mWysłano REQUEST do serwera %d (epoka %u, próba %d)\033[0m\n",
+               server.id, epoch, attempts);
+
+        if(marked_down) {
+            printf("\033[31mSerwer %d nie odpowiada, oznaczanie jako DOWN\033[0m\n",
+                   server.id);
+            atomic_fetch_and(&probe_round.pending_probes, ~(1u << i));
+            print_servers();
         }
     }
 }
@@ -121,45 +277,33 @@ void handle_pong_response(const char* message, struct timeval* current_time) {
         double rtt = (end_time.tv_sec - ping_state.start_time.tv_sec) * 1000.0 +
                     (end_time.tv_usec - ping_state.start_time.tv_usec) / 1000.0;
 
+        // localtime_r() + strftime() w formacie ctime() - ctime() przy każdym wywołaniu
+        // ponownie sprawdza strefę czasową i alokuje pamięć
         time_t now = time(NULL);
-        char* timestamp = ctime(&now);
-        timestamp[strlen(timestamp)-1] = '\0';  // Usunięcie znaku nowej linii
+        struct tm local_time;
+        char timestamp[32];
+        localtime_r(&now, &local_time);
+        strftime(timestamp, sizeof(timestamp), "%a %b %e %H:%M:%S %Y", &local_time);
 
         printf("\033[36mOtrzymano PONG: %s, RTT: %.3f ms, Czas: %s\033[0m\n",
                message,
                rtt,
                timestamp);
 
-        ping_state.waiting_for_pong = 0;
-    }
-}
-
-// Funkcja wybierająca losowy aktywny serwer
-int get_random_active_server() {
-    if (server_count == 0) return -1;
-
-    int active_servers = 0;
-    for(int i = 0; i < server_count; i++) {
-        if(servers[i].status == UP) {
-            active_servers++;
-        }
-    }
-
-    if (active_servers == 0) return -1;
-
-    int target = rand() % active_servers;
-    int current = 0;
-
-    for(int i = 0; i < server_count; i++) {
-        if(servers[i].status == UP) {
-            if(current == target) {
-                return i;
+        // Aktualizacja wygładzonego RTT serwera (zapisywanego w migawce)
+        int index = ping_state.server_index;
+        if (index >= 0 && index < atomic_load(&server_count)) {
+            registry_write_begin(index);
+            if (servers[index].srtt_ms == 0) {
+                servers[index].srtt_ms = rtt;
+            } else {
+                servers[index].srtt_ms += RTT_SMOOTHING * (rtt - servers[index].srtt_ms);
             }
-            current++;
+            registry_write_end(index);
         }
-    }
 
-    return -1;
+        ping_state.waiting_for_pong = 0;
+    }
 }
 
 // Funkcja wysyłająca wiadomość PING do losowego serwera
@@ -171,7 +315,7 @@ void send_pings(int client_socket) {
         return;
     }
 
-    // Dynamiczna alokacja pamięci dla wiadomości
+    // Bufory z puli dla wiadomości
     char* message = generate_random_string(PING_MESSAGE_LEN);
     char* message_with_header = add_header(message, PING);
 
@@ -180,70 +324,86 @@ void send_pings(int client_socket) {
 
     gettimeofday(&ping_state.start_time, NULL);
     ping_state.waiting_for_pong = 1;
+    ping_state.server_index = server_index;
+
+    struct ServerInfo server;
+    registry_read(server_index, &server);
 
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(servers[server_index].port);
-    inet_pton(AF_INET, servers[server_index].ip, &server_addr.sin_addr);
+    server_addr.sin_port = htons(server.port);
+    inet_pton(AF_INET, server.ip, &server_addr.sin_addr);
 
     printf("\033[34mWysyłanie PING do serwera %d (IP: %s, Port: %d): %s\033[0m\n",
-           servers[server_index].id,
-           servers[server_index].ip,
-           servers[server_index].port,
+           server.id,
+           server.ip,
+           server.port,
            message_with_header);
 
-    sendto(client_socket,
-           message_with_header,
-           strlen(message_with_header),
-           0,
-           (struct sockaddr*)&server_addr,
-           sizeof(server_addr));
+    queue_message(client_socket,
+                  server_index,
+                  message_with_header,
+                  strlen(message_with_header),
+                  &server_addr);
 
-    // Zwalnianie zaalokowanej pamięci
-    free(message);
-    free(message_with_header);
+    // Zwrócenie buforów do puli
+    pool_free(&packet_pool, message);
+    pool_free(&packet_pool, message_with_header);
 }
 // Funkcja obsługująca wiadomości HELLO od serwerów
 // Parametry:
-// message - wskaźnik na ciąg znaków zawierający wiadomość (pamięć dynamiczna)
+// message - treść wiadomości (ID serwera i opcjonalnie port aktywności) w buforze odbiorczym,
+//           length - jej długość
 // ip - stały wskaźnik na ciąg znaków z adresem IP (nie będzie modyfikowany)
 // port - numer portu jako liczba całkowita
-void server_hello_handler(char* message, const char* ip, int port) {
-    // Wyciągnięcie ID serwera z wiadomości tekstowej przy użyciu sscanf
-    // sscanf analizuje tekst i próbuje znaleźć liczbę całkowitą
-    int server_id;
-    if (sscanf(message, "%d", &server_id) != 1) {
+void server_hello_handler(const char* message, int length, const char* ip, int port) {
+    // Wyciągnięcie ID serwera z wiadomości tekstowej - parse_hello zamiast sscanf.
+    // Serwer bez osobnego gniazda aktywności nie podaje portu - REQUEST idą na port danych
+    int server_id, liveness_port;
+    if (parse_hello(message, length, &server_id, &liveness_port) < 0) {
         printf("Nie udało się odczytać ID serwera\n");
         return;
     }
+    if (liveness_port == 0) {
+        liveness_port = port;
+    }
 
     // Sprawdzenie czy serwer już istnieje w tablicy serwerów
-    for(int i = 0; i < server_count; i++) {
+    int count = atomic_load(&server_count);
+    for(int i = 0; i < count; i++) {
         if(servers[i].id == server_id) {
             // Aktualizacja danych istniejącego serwera
             // strcpy kopiuje ciąg znaków do bufora o określonym rozmiarze
+            registry_write_begin(i);
             strcpy(servers[i].ip, ip);
             servers[i].port = port;
-            servers[i].status = UP;
+            servers[i].liveness_port = liveness_port;
+            registry_write_end(i);
+            atomic_store(&servers[i].liveness, LIVENESS(UP, 0));
             printf("Zaktualizowano serwer %d\n", server_id);
             return;
         }
     }
 
     // Dodanie nowego serwera jeśli jest miejsce w tablicy
-    if(server_count < MAX_SERVERS) {
-        // Wypełnienie struktury ServerInfo danymi nowego serwera
-        servers[server_count].id = server_id;
-        strcpy(servers[server_count].ip, ip);
-        servers[server_count].port = port;
-        servers[server_count].status = UP;
-        servers[server_count].failed_requests = 0;
-        servers[server_count].last_request_time = time(NULL);
-        servers[server_count].last_request_time_usec = 0;
-        printf("Dodano nowy serwer %d o IP: %s Port: %d\n",
-               server_id, ip, port);
-        server_count++;
+    if(count < MAX_SERVERS) {
+        // Wypełnienie struktury ServerInfo danymi nowego serwera - wpis nie jest
+        // jeszcze widoczny dla czytelników, więc seqlock nie jest potrzebny
+        servers[count].id = server_id;
+        strcpy(servers[count].ip, ip);
+        servers[count].port = port;
+        servers[count].liveness_port = liveness_port;
+        atomic_store(&servers[count].liveness, LIVENESS(UP, 0));
+        servers[count].last_seen = 0;
+        servers[count].last_seen_usec = 0;
+        servers[count].srtt_ms = 0;
+        printf("Dodano nowy serwer %d o IP: %s Port: %d (aktywność: %d)\n",
+               server_id, ip, port, liveness_port);
+        // Publikacja wpisu - licznik zwiększany dopiero po wypełnieniu wpisu
+        atomic_store(&server_count, count + 1);
+        // Licznik w migawce zwiększany dopiero po wypełnieniu wpisu
+        registry->server_count = count + 1;
     } else {
         printf("Lista serwerów pełna!\n");
     }
@@ -252,31 +412,96 @@ void server_hello_handler(char* message, const char* ip, int port) {
 // Funkcja wyświetlająca listę wszystkich znanych serwerów
 void print_servers() {
     printf("\nZnane serwery:\n");
-    for(int i = 0; i < server_count; i++) {
-        printf("ID serwera: %d, IP: %s, Port: %d, Status: %s\n",
-               servers[i].id,
-               servers[i].ip,
-               servers[i].port,
-               servers[i].status ? "AKTYWNY" : "NIEAKTYWNY");
+    int count = atomic_load(&server_count);
+    for(int i = 0; i < count; i++) {
+        struct ServerInfo server;
+        registry_read(i, &server);
+        printf("ID serwera: %d, IP: %s, Port: %d, Status: %s, SRTT: %.3f ms\n",
+               server.id,
+               server.ip,
+               server.port,
+               LIVENESS_STATUS(server.liveness) == UP ? "AKTYWNY" : "NIEAKTYWNY",
+               server.srtt_ms);
     }
     printf("\n");
 }
 
+// Funkcja obsługująca pojedynczą wiadomość protokołu (samodzielny datagram
+// albo jedna wiadomość wyjęta z ramki zbiorczej)
+// buffer - wiadomość z nagłówkiem zakończona znakiem null, już sprawdzona
+// przez parse_classify(), length - jej długość
+void dispatch_message(char* buffer, int length, const char* sender_ip, int sender_port,
+                      struct timeval* recv_time) {
+    // Wyodrębnienie nagłówka i wiadomości - treść jest czytana wprost z bufora
+    // odbiorczego (też zakończona znakiem null), bez kopiowania
+    char header = buffer[0];
+    const char* message = buffer + 1;
+    int message_length = length - 1;
+
+    printf("\033[35mOtrzymano wiadomość: [%c]%s\033[0m\n",
+                   header, buffer + 1);
+
+    // Indeks nadawcy w tablicy serwerów (-1 jeśli nieznany - np. przed pierwszym HELLO)
+    int sender_index = find_server(sender_ip, sender_port);
+
+    // Obsługa różnych typów wiadomości
+    switch(header) {
+        case HELLO:
+            printf("\033[32mOtrzymano wiadomość HELLO\033[0m\n");
+            server_hello_handler(message, message_length, sender_ip, sender_port);
+            // Resetowanie licznika nieudanych prób i ustawienie statusu na AKTYWNY
+            sender_index = find_server(sender_ip, sender_port);
+            if(sender_index != -1) {
+                mark_server_alive(sender_index, recv_time);
+                printf("\033[32mSerwer %d reaktywowany\033[0m\n", servers[sender_index].id);
+            }
+            print_servers();
+            break;
+        case PING:
+            printf("\033[32mOtrzymano wiadomość PING: %s\033[0m\n", message);
+            break;
+        case PONG:
+            handle_pong_response(message, recv_time);
+            // PONG potwierdza aktywność - w tej rundzie REQUEST nie jest potrzebny
+            if(sender_index != -1) {
+                mark_server_alive(sender_index, recv_time);
+            }
+            break;
+        case REQUEST:
+            printf("\033[32mOtrzymano wiadomość REQUEST: %s\033[0m\n", message);
+            break;
+        case RESPONSE:
+            printf("\033[32mOtrzymano RESPONSE od %s:%d\033[0m\n",
+                   sender_ip, sender_port);
+            // Odpowiedź z epoką inną niż bieżąca jest spóźniona, ale nadal
+            // potwierdza aktywność serwera
+            unsigned int epoch = atomic_load(&probe_round.epoch);
+            unsigned int response_epoch;
+            if(parse_epoch(message, message_length, &response_epoch) == 0 &&
+               response_epoch != epoch) {
+                printf("\033[33mSpóźniona odpowiedź z epoki %s (bieżąca %u)\033[0m\n",
+                       message, epoch);
+            }
+            // Aktualizacja statusu serwera
+            if(sender_index != -1) {
+                mark_server_alive(sender_index, NULL);
+            }
+            break;
+        default:
+            printf("\033[31mNieznany typ wiadomości: %c\033[0m\n", header);
+    }
+}
+
 // Główna funkcja nasłuchująca na wiadomości od serwerów
 // Obsługuje odbiór pakietów UDP i ich przetwarzanie
-void client_listen(int server_socket, struct sockaddr_in sender_addr, socklen_t client_len) {
-    // Bufor na dane przychodzące - tablica znaków alokowana na stosie
-    char buffer[BUFFER_SIZE];
-    socklen_t sender_len = sizeof(sender_addr);
+void client_listen(int server_socket, struct sockaddr_in sender_addr) {
+    // Bufor na dane przychodzące - tablica znaków alokowana na stosie.
+    // Zapas PARSE_PADDING pozwala walidacji czytać pełne bloki wektorowe za końcem danych
+    char buffer[BUFFER_SIZE + PARSE_PADDING];
     struct timeval recv_time;  // Struktura na czas otrzymania pakietu
 
-    // Odebranie pakietu UDP
-    int recv_len = recvfrom(server_socket,
-                           buffer,
-                           BUFFER_SIZE,
-                           0,
-                           (struct sockaddr*)&sender_addr,
-                           &client_len);
+    // Odebranie pakietu UDP (BUFFER_SIZE - 1, aby zostało miejsce na terminator null)
+    int recv_len = receive_datagram(server_socket, buffer, BUFFER_SIZE - 1, &sender_addr);
 
     if (recv_len > 0) {
         // Natychmiastowy pomiar czasu otrzymania
@@ -290,73 +515,156 @@ void client_listen(int server_socket, struct sockaddr_in sender_addr, socklen_t
         inet_ntop(AF_INET, &(sender_addr.sin_addr), sender_ip, MAX_IP_LENGTH);
         int sender_port = ntohs(sender_addr.sin_port);
 
-        // Wyodrębnienie nagłówka i wiadomości
-        char header = buffer[0];
-        // Dynamiczna alokacja pamięci na wiadomość
-        char* message = malloc(recv_len);  // Pamięć będzie zwolniona na końcu funkcji
-        strcpy(message, buffer + 1);
-
-        printf("\033[35mOtrzymano wiadomość: [%c]%s\033[0m\n",
-                       header, buffer + 1);
-
-        // Obsługa różnych typów wiadomości
-        switch(header) {
-            case HELLO:
-                printf("\033[32mOtrzymano wiadomość HELLO\033[0m\n");
-                server_hello_handler(message, sender_ip, sender_port);
-                // Resetowanie licznika nieudanych prób i ustawienie statusu na AKTYWNY
-                for(int i = 0; i < server_count; i++) {
-                    if(strcmp(servers[i].ip, sender_ip) == 0 &&
-                       servers[i].port == sender_port) {
-                        servers[i].failed_requests = 0;
-                        servers[i].status = UP;
-                        servers[i].last_request_time = time(NULL);
-                        servers[i].last_request_time_usec = 0;
-                        printf("\033[32mSerwer %d reaktywowany\033[0m\n", servers[i].id);
-                        break;
-                    }
-                }
-                print_servers();
-                break;
-            case PING:
-                printf("\033[32mOtrzymano wiadomość PING: %s\033[0m\n", message);
-                break;
-            case PONG:
-                handle_pong_response(message, &recv_time);
-                // Aktualizacja statusu serwera
-                for(int i = 0; i < server_count; i++) {
-                    if(strcmp(servers[i].ip, sender_ip) == 0 &&
-                       servers[i].port == sender_port) {
-                        servers[i].status = UP;
-                        break;
-                    }
-                }
-                break;
-            case REQUEST:
-                printf("\033[32mOtrzymano wiadomość REQUEST: %s\033[0m\n", message);
-                break;
-            case RESPONSE:
-                printf("\033[32mOtrzymano RESPONSE od %s:%d\033[0m\n",
+        // Walidacja przed obsługą - nieznany nagłówek, zła treść albo uszkodzona
+        // ramka zbiorcza odrzucają cały datagram
+        char type = parse_classify(buffer, recv_len);
+        if (type == 0) {
+            malformed_messages++;
+            printf("\033[31mOdrzucono niepoprawny datagram od %s:%d (%d B, łącznie %lu)\033[0m\n",
+                   sender_ip, sender_port, recv_len, malformed_messages);
+            return;
+        }
+
+        if (type == PACKED) {
+            // Ramka zbiorcza - każda wiadomość obsługiwana osobno
+            int offset = 1;
+            const char* packed;
+            int length;
+            int result;
+            while ((result = frame_next(buffer, recv_len, &offset, &packed, &length)) > 0) {
+                // Wiadomość z ramki zakończona znakiem null (z zapasem dla parse_decimal)
+                char message[PACK_MAX_MESSAGE + 1 + PARSE_PADDING];
+                memcpy(message, packed, length);
+                message[length] = '\0';
+                dispatch_message(message, length, sender_ip, sender_port, &recv_time);
+            }
+            if (result < 0) {
+                printf("\033[31mUszkodzona ramka zbiorcza od %s:%d\033[0m\n",
                        sender_ip, sender_port);
-                // Aktualizacja statusu serwera
-                for(int i = 0; i < server_count; i++) {
-                    if(strcmp(servers[i].ip, sender_ip) == 0 &&
-                       servers[i].port == sender_port) {
-                        servers[i].failed_requests = 0;
-                        servers[i].status = UP;
-                        break;
-                    }
-                }
-                break;
-            default:
-                printf("\033[31mNieznany typ wiadomości: %c\033[0m\n", header);
+            }
+        } else {
+            dispatch_message(buffer, recv_len, sender_ip, sender_port, &recv_time);
+        }
+    }
+}
+
+// Funkcja ustawiająca bufory gniazda z konfiguracji (po przeładowaniu)
+void apply_socket_buffers(int sock) {
+    udp_set_buffers(sock, current_config()->socket_rcvbuf, current_config()->socket_sndbuf);
+}
+
+// Funkcja ustawiająca bufory gniazda i włączająca licznik zgubionych pakietów
+void configure_socket(int sock) {
+    udp_configure(sock, current_config()->socket_rcvbuf, current_config()->socket_sndbuf);
+}
+
+// Funkcja odbierająca jeden datagram przez recvmsg(), aby odczytać licznik SO_RXQ_OVFL
+// Zwraca liczbę odebranych bajtów (jak recvfrom)
+int receive_datagram(int sock, char* buffer, size_t length, struct sockaddr_in* sender_addr) {
+    struct iovec iov = { .iov_base = buffer, .iov_len = length };
+    char control[UDP_DROPS_CONTROL_SIZE];
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_name = sender_addr;
+    hdr.msg_namelen = sizeof(*sender_addr);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    int recv_len = recvmsg(sock, &hdr, 0);
+    if (recv_len < 0) {
+        return recv_len;
+    }
+    capture_record(CAPTURE_IN, sender_addr, buffer, recv_len);
+
+    uint32_t latest;
+    if (udp_drop_counter(&hdr, &latest) && latest != kernel_drops) {
+        printf("\033[31mJądro odrzuciło %u pakietów (łącznie %u) - pełny bufor odbiorczy\033[0m\n",
+               latest - kernel_drops, latest);
+        kernel_drops = latest;
+    }
+
+    return recv_len;
+}
+
+// Funkcja kolejkująca wiadomość do serwera. Bez ramek zbiorczych (packed_frames) wysyła
+// od razu, w przeciwnym razie dopisuje do ramki serwera, która wychodzi gdy się zapełni
+// albo po pack_flush_deadline_ms (flush_pending_frames)
+void queue_message(int sock, int server_index, const char* data, size_t length, struct sockaddr_in* addr) {
+    if (!current_config()->packed_frames) {
+        send_datagram(sock, data, length, addr);
+        return;
+    }
+
+    struct PendingFrame* pending = &pending_frames[server_index];
+    // REQUEST idzie na port aktywności, a PING na port danych - ramka ma jeden adres,
+    // więc wiadomość na inny port wysyła najpierw to, co już czeka
+    if (pending->frame.count > 0 &&
+        (pending->addr.sin_port != addr->sin_port ||
+         pending->addr.sin_addr.s_addr != addr->sin_addr.s_addr)) {
+        frame_send(sock, &pending->frame, &pending->addr);
+    }
+    if (!frame_append(&pending->frame, data, length)) {
+        // Ramka pełna - wysłanie i próba w pustej ramce
+        frame_send(sock, &pending->frame, &pending->addr);
+        if (!frame_append(&pending->frame, data, length)) {
+            // Wiadomość dłuższa niż PACK_MAX_MESSAGE - osobny datagram
+            send_datagram(sock, data, length, addr);
+            return;
         }
+    }
+
+    if (pending->frame.count == 1) {
+        pending->addr = *addr;
+        gettimeofday(&pending->first_queued, NULL);
+    }
+}
+
+// Funkcja wysyłająca ramki, których termin minął
+// force - 1 = wysłanie wszystkich niepustych ramek
+void flush_pending_frames(int sock, int force) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
 
-        // Zwolnienie zaalokowanej pamięci na wiadomość
-        free(message);
+    for (int i = 0; i < server_count; i++) {
+        struct PendingFrame* pending = &pending_frames[i];
+        if (pending->frame.count == 0) {
+            continue;
+        }
+        long waited_ms = (now.tv_sec - pending->first_queued.tv_sec) * 1000 +
+                         (now.tv_usec - pending->first_queued.tv_usec) / 1000;
+        if (force || waited_ms >= current_config()->pack_flush_deadline_ms) {
+            frame_send(sock, &pending->frame, &pending->addr);
+        }
     }
 }
 
+// Funkcja zwracająca, ile mikrosekund select() może czekać, aby nie przekroczyć
+// terminu żadnej ramki (najwyżej default_usec)
+long pending_frames_timeout(long default_usec) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    long timeout = default_usec;
+
+    for (int i = 0; i < server_count; i++) {
+        struct PendingFrame* pending = &pending_frames[i];
+        if (pending->frame.count == 0) {
+            continue;
+        }
+        long waited_usec = (now.tv_sec - pending->first_queued.tv_sec) * 1000000 +
+                           (now.tv_usec - pending->first_queued.tv_usec);
+        long left_usec = current_config()->pack_flush_deadline_ms * 1000L - waited_usec;
+        if (left_usec < 0) {
+            left_usec = 0;
+        }
+        if (left_usec < timeout) {
+            timeout = left_usec;
+        }
+    }
+    return timeout;
+}
+
 // Funkcja dodająca nagłówek do wiadomości
 // Tworzy nową wiadomość w pamięci dynamicznej
 char* add_header(char* message, char header) {
@@ -368,8 +676,11 @@ char* add_header(char* message, char header) {
     size_t msg_len = strlen(message);
     size_t new_len = msg_len + 2;  // +1 na nagłówek, +1 na terminator null
 
-    // Dynamiczna alokacja pamięci na nową wiadomość
-    char* new_message = (char*)malloc(new_len);
+    // Bufor z puli na nową wiadomość
+    if (new_len > packet_pool.object_size) {
+        return NULL;
+    }
+    char* new_message = (char*)pool_alloc(&packet_pool);
     if (new_message == NULL) {
         return NULL;
     }
@@ -378,7 +689,7 @@ char* add_header(char* message, char header) {
     new_message[0] = header;
     strcpy(new_message + 1, message);  // Skopiowanie za nagłówkiem
 
-    return new_message;  // Zwrócenie wskaźnika - pamięć musi być zwolniona przez wywołującego
+    return new_message;  // Zwrócenie wskaźnika - bufor musi być zwrócony przez pool_free()
 }
 
 // Inicjalizacja generatora liczb pseudolosowych
@@ -391,8 +702,14 @@ void init_random_generator_seed() {
 
 // Funkcja generująca losowy ciąg znaków określonej długości
 char* generate_random_string(int length) {
-    // Dynamiczna alokacja pamięci na ciąg znaków
-    char* random_string = (char*)malloc(length + 1);
+    // Bufor z puli na ciąg znaków
+    if ((size_t)length + 1 > packet_pool.object_size) {
+        return NULL;
+    }
+    char* random_string = (char*)pool_alloc(&packet_pool);
+    if (random_string == NULL) {
+        return NULL;
+    }
 
     const char charset[] = "0123456789"
                          "abcdefghijklmnopqrstuvwxyz";
@@ -407,7 +724,7 @@ char* generate_random_string(int length) {
 
     random_string[length] = '\0';  // Dodanie terminatora null
 
-    return random_string;  // Zwrócenie wskaźnika - pamięć musi być zwolniona przez wywołującego
+    return random_string;  // Zwrócenie wskaźnika - bufor musi być zwrócony przez pool_free()
 }
 
 // Funkcja wysyłająca pakiet PING do serwera i obsługująca odpowiedź
@@ -429,8 +746,13 @@ void ping_server(int client_socket, struct sockaddr_in server_addr, socklen_t se
             return;
     }
 
-    // Dodanie nagłówka do wiadomości - zwraca nowy wskaźnik, stary zostanie zwolniony
-    message = add_header(message,PING);
+    // Dodanie nagłówka do wiadomości - zwraca nowy bufor, losowy ciąg jest od razu zwracany
+    char *random_part = message;
+    message = add_header(random_part, PING);
+    pool_free(&packet_pool, random_part);
+    if (message == NULL) {
+            return;
+    }
 
     printf("\033[34mWysyłanie: %s \033[0m\n", message);
 
@@ -438,12 +760,7 @@ void ping_server(int client_socket, struct sockaddr_in server_addr, socklen_t se
     gettimeofday(&start, NULL);
 
     // Wysłanie wiadomości przez UDP używając struktury sockaddr_in
-    sendto(client_socket,
-           message,
-           strlen(message),
-           0,
-           (struct sockaddr*)&server_addr,  // Rzutowanie na ogólną strukturę adresu
-           sizeof(server_addr));
+    send_datagram(client_socket, message, strlen(message), &server_addr);
 
     // Oczekiwanie na odpowiedź i zapis do bufora
     int recv_len = recvfrom(client_socket,
@@ -471,36 +788,148 @@ void ping_server(int client_socket, struct sockaddr_in server_addr, socklen_t se
                    timestamp);
         }
 
-    free(message);  // Zwolnienie pamięci zaalokowanej dla wiadomości
+    pool_free(&packet_pool, message);  // Zwrócenie bufora wiadomości do puli
     sleep(1);       // Wstrzymanie wykonania na 1 sekundę
 }
 
+// Funkcja mapująca plik migawki rejestru i wczytująca zapisane serwery.
+// Wczytane serwery są oznaczane jako AKTYWNE z wyzerowanymi licznikami, więc pierwsza
+// runda send_keep_alive_check() od razu je sprawdza - nieodpowiadające przejdą w DOWN
+// po max_request_attempts rundach. Przy błędzie klient działa na pamięci statycznej.
+void snapshot_open() {
+    int fd = open(SNAPSHOT_PATH, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("Ostrzeżenie: migawka rejestru");
+        return;
+    }
+
+    struct stat st;
+    int fresh = fstat(fd, &st) < 0 || st.st_size != sizeof(struct RegistrySnapshot);
+    if (fresh && ftruncate(fd, sizeof(struct RegistrySnapshot)) < 0) {
+        perror("Ostrzeżenie: migawka rejestru");
+        close(fd);
+        return;
+    }
+
+    void* mapped = mmap(NULL, sizeof(struct RegistrySnapshot),
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // Mapowanie pozostaje ważne po zamknięciu deskryptora
+    if (mapped == MAP_FAILED) {
+        perror("Ostrzeżenie: mmap migawki rejestru");
+        return;
+    }
+
+    registry = (struct RegistrySnapshot*)mapped;
+    registry_mapped = 1;
+    servers = registry->entries;
+
+    if (fresh ||
+        registry->magic != SNAPSHOT_MAGIC ||
+        registry->version != SNAPSHOT_VERSION ||
+        registry->entry_size != sizeof(struct ServerInfo) ||
+        registry->max_servers != MAX_SERVERS ||
+        registry->server_count < 0 ||
+        registry->server_count > MAX_SERVERS) {
+        // Nowy albo niezgodny plik - zaczynamy z pustym rejestrem
+        memset(registry, 0, sizeof(*registry));
+        registry->magic = SNAPSHOT_MAGIC;
+        registry->version = SNAPSHOT_VERSION;
+        registry->entry_size = sizeof(struct ServerInfo);
+        registry->max_servers = MAX_SERVERS;
+        atomic_store(&server_count, 0);
+        printf("Utworzono nową migawkę rejestru: %s\n", SNAPSHOT_PATH);
+        return;
+    }
+
+    for (int i = 0; i < registry->server_count; i++) {
+        atomic_store(&servers[i].seq, 0);  // Zapis przerwany w trakcie zostawił nieparzysty licznik
+        atomic_store(&servers[i].liveness, LIVENESS(UP, 0));
+        servers[i].last_seen = 0;
+        servers[i].last_seen_usec = 0;
+    }
+    atomic_store(&server_count, registry->server_count);
+    printf("\033[32mWczytano %d serwerów z migawki %s\033[0m\n", registry->server_count, SNAPSHOT_PATH);
+    print_servers();
+}
+
+// Funkcja zlecająca zapis zmienionych stron migawki na dysk.
+// MS_ASYNC nie blokuje pętli - jądro zapisze tylko zmodyfikowane strony
+// force - 1 = zapis niezależnie od snapshot_sync_interval
+void snapshot_sync(int force) {
+    static time_t last_sync = 0;
+    time_t now = time(NULL);
+
+    if (!registry_mapped || (!force && now - last_sync < current_config()->snapshot_sync_interval)) {
+        return;
+    }
+    msync(registry, sizeof(*registry), MS_ASYNC);
+    last_sync = now;
+}
+
 // Funkcja zwracająca losowy interwał w milisekundach
 int get_random_ping_interval() {
-    return 1500 + (rand() % 1051);  // Losowa liczba z zakresu 1500-2550ms
+    // Losowa liczba z zakresu ping_interval_min_ms-ping_interval_max_ms (domyślnie 1500-2550ms)
+    int min = current_config()->ping_interval_min_ms;
+    int max = current_config()->ping_interval_max_ms;
+    return min + (rand() % (max - min + 1));
+}
+
+// Funkcja stosująca przeładowaną konfigurację (wywoływana w pętli głównej po SIGHUP).
+// Pozostałe klucze działają od następnego użycia - są czytane przez current_config()
+void apply_config_reload(int client_socket) {
+    if (!config_poll(&config_set)) {
+        return;
+    }
+
+    apply_socket_buffers(client_socket);
+    // Po wyłączeniu ramek zbiorczych nic nie może zostać w kolejce
+    flush_pending_frames(client_socket, 1);
 }
 
 // Główna funkcja programu
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        printf("Użycie: %s [plik_zapisu_ruchu]\n", argv[0]);
+        return 1;
+    }
+
     printf("Klient\n");
     init_random_generator_seed();  // Inicjalizacja generatora liczb pseudolosowych
 
+    if (config_init(&config_set) < 0) {
+        exit(1);
+    }
+    config_print(&config_set);
+    signals_init();
+
+    // Opcjonalny zapis całego ruchu do pliku (do odtworzenia programem replay)
+    if (argc == 2 && capture_open(argv[1], CAPTURE_ROLE_CLIENT) < 0) {
+        exit(1);
+    }
+
+    if (pool_init(&packet_pool, "wiadomości", BUFFER_SIZE, PACKET_POOL_SLAB) < 0) {
+        exit(1);
+    }
+
+    parse_init();
+    printf("Walidacja wiadomości: %s\n", parse_implementation());
+
     // Deklaracja zmiennych do obsługi socketu UDP
     int client_socket;
     struct sockaddr_in server_addr, client_addr;    // Struktury przechowujące adresy IP i porty
     char buffer[BUFFER_SIZE];                       // Statyczna alokacja bufora na dane
-    socklen_t server_len = sizeof(server_addr);     // Rozmiar struktury adresu
 
     // Utworzenie gniazda UDP
     client_socket = socket(AF_INET,     // Rodzina protokołów IPv4
                           SOCK_DGRAM,   // Typ gniazda - UDP
                           0);           // Protokół domyślny
+    configure_socket(client_socket);
 
     // Inicjalizacja struktury adresu klienta
     memset(&client_addr, 0, sizeof(client_addr));   // Wyzerowanie pamięci struktury
     client_addr.sin_family = AF_INET;               // Ustawienie rodziny na IPv4
     client_addr.sin_addr.s_addr = INADDR_ANY;       // Nasłuchiwanie na wszystkich interfejsach
-    client_addr.sin_port = htons(CLIENT_PORT);      // Konwersja numeru portu na format sieciowy
+    client_addr.sin_port = htons(current_config()->client_port);  // Konwersja numeru portu na format sieciowy
 
     // Przypisanie adresu do gniazda
     if (bind(client_socket,
@@ -510,6 +939,13 @@ int main() {
         exit(1);
     }
 
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        frame_init(&pending_frames[i].frame);
+    }
+
+    // Wczytanie znanych serwerów z poprzedniego uruchomienia
+    snapshot_open();
+
     // Zmienne do obsługi select() - mechanizmu multipleksowania we/wy
     fd_set readfds;           // Zestaw deskryptorów do monitorowania
     struct timeval tv;        // Struktura na timeout
@@ -517,22 +953,29 @@ int main() {
     gettimeofday(&last_ping_time, NULL);
     int current_ping_interval = get_random_ping_interval();
 
-    // Główna pętla programu
-    while (1) {
+    // Główna pętla programu - do błędu select() albo sygnału zakończenia
+    while (!shutdown_requested()) {
         FD_ZERO(&readfds);    // Wyczyszczenie zestawu deskryptorów
         FD_SET(client_socket, &readfds);  // Dodanie socketu do monitorowania
 
         tv.tv_sec = 0;
-        tv.tv_usec = 100000;  // Timeout 100ms
+        tv.tv_usec = pending_frames_timeout(100000);  // Timeout 100ms albo do terminu ramki
 
         // Oczekiwanie na aktywność na gnieździe
         int activity = select(client_socket + 1, &readfds, NULL, NULL, &tv);
 
-        if (activity < 0) {
+        // EINTR - select() przerwany sygnałem (np. SIGHUP przeładowania konfiguracji)
+        if (activity < 0 && errno != EINTR) {
             printf("Select error");
             break;
         }
 
+        // Przeładowanie konfiguracji i raport puli (SIGUSR1) między obsługą pakietów
+        apply_config_reload(client_socket);
+        if (report_requested()) {
+            pool_report(&packet_pool);
+        }
+
         // Sprawdzenie czy nadszedł czas na wysłanie pinga
         struct timeval current_time;
         gettimeofday(&current_time, NULL);
@@ -550,12 +993,24 @@ int main() {
         // Wysłanie zapytań kontrolnych
         send_keep_alive_check(client_socket);
 
+        // Wysłanie ramek zbiorczych, których termin minął
+        flush_pending_frames(client_socket, 0);
+
+        // Okresowy zapis zmienionych stron migawki rejestru
+        snapshot_sync(0);
+
         // Obsługa przychodzących danych
-        if (FD_ISSET(client_socket, &readfds)) {
-            client_listen(client_socket, server_addr, server_len);
+        if (activity > 0 && FD_ISSET(client_socket, &readfds)) {
+            client_listen(client_socket, server_addr);
         }
     }
 
+    printf("Zamykanie klienta\n");
+    flush_pending_frames(client_socket, 1);
+    snapshot_sync(1);
+    pool_destroy(&packet_pool);
+    config_destroy(&config_set);
+    capture_close();
     close(client_socket);  // Zamknięcie gniazda
     return 0;
 }
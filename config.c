@@ -0,0 +1,228 @@
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+
+// Flaga ustawiana przez SIGHUP - obsługa sygnału tylko ją zapisuje,
+// samo wczytanie pliku odbywa się w pętli głównej (config_poll)
+static volatile sig_atomic_t reload_requested = 0;
+
+static void config_signal_handler(int signal_number) {
+    (void)signal_number;
+    reload_requested = 1;
+}
+
+// Funkcja usuwająca białe znaki z początku i końca napisu (w miejscu)
+static char* config_trim(char* text) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    char* end = text + strlen(text);
+    while (end > text && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) {
+        end--;
+    }
+    *end = '\0';
+    return text;
+}
+
+static const struct ConfigOption* config_find(struct ConfigSet* set, const char* key) {
+    for (int i = 0; i < set->option_count; i++) {
+        if (strcmp(set->options[i].key, key) == 0) {
+            return &set->options[i];
+        }
+    }
+    return NULL;
+}
+
+// Funkcja wczytująca plik do struktury config (wcześniej wypełnionej wartościami domyślnymi)
+// Zwraca 0, 1 gdy pliku nie ma, albo -1 przy błędzie w pliku
+static int config_parse_file(struct ConfigSet* set, void* config) {
+    FILE* file = fopen(set->path, "r");
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        perror("Błąd konfiguracji");
+        return -1;
+    }
+
+    char line[CONFIG_MAX_LINE];
+    int line_number = 0;
+    int result = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        char* text = config_trim(line);
+        if (*text == '\0') {
+            continue;
+        }
+
+        char* separator = strchr(text, '=');
+        if (separator == NULL) {
+            printf("\033[31m%s:%d: brak '='\033[0m\n", set->path, line_number);
+            result = -1;
+            continue;
+        }
+        *separator = '\0';
+        char* key = config_trim(text);
+        char* value = config_trim(separator + 1);
+
+        const struct ConfigOption* option = config_find(set, key);
+        if (option == NULL) {
+            printf("\033[31m%s:%d: nieznany klucz '%s'\033[0m\n", set->path, line_number, key);
+            result = -1;
+            continue;
+        }
+
+        char* field = (char*)config + option->offset;
+        if (option->type == CONFIG_INT) {
+            char* end;
+            errno = 0;
+            long number = strtol(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || errno != 0 ||
+                number < option->min || number > option->max) {
+                printf("\033[31m%s:%d: %s = '%s' - oczekiwano liczby z zakresu %d..%d\033[0m\n",
+                       set->path, line_number, key, value, option->min, option->max);
+                result = -1;
+                continue;
+            }
+            *(int*)field = (int)number;
+        } else {
+            if (strlen(value) >= (size_t)option->max) {
+                printf("\033[31m%s:%d: %s - napis dłuższy niż %d znaków\033[0m\n",
+                       set->path, line_number, key, option->max - 1);
+                result = -1;
+                continue;
+            }
+            strcpy(field, value);
+        }
+    }
+
+    fclose(file);
+    return result;
+}
+
+// Funkcja wypisująca wartość jednego klucza
+static void config_print_value(const struct ConfigOption* option, const void* config) {
+    const char* field = (const char*)config + option->offset;
+    if (option->type == CONFIG_INT) {
+        printf("%d", *(const int*)field);
+    } else {
+        printf("%s", field);
+    }
+}
+
+// Funkcja wczytująca nową konfigurację. current - obecna konfiguracja albo NULL przy starcie.
+// Zwraca nową strukturę albo NULL, gdy plik jest błędny
+static void* config_load(struct ConfigSet* set, const void* current) {
+    void* config = malloc(set->size);
+    if (config == NULL) {
+        return NULL;
+    }
+    // Klucz usunięty z pliku wraca do wartości domyślnej
+    memcpy(config, set->defaults, set->size);
+
+    int result = config_parse_file(set, config);
+    if (result == 0 && set->validate != NULL && set->validate(config) < 0) {
+        result = -1;
+    }
+    if (result < 0) {
+        free(config);
+        return NULL;
+    }
+    if (result == 1) {
+        printf("Brak pliku konfiguracji %s - wartości domyślne\n", set->path);
+    }
+    if (current == NULL) {
+        return config;
+    }
+
+    // Klucze stosowane tylko przy starcie zachowują obecną wartość
+    for (int i = 0; i < set->option_count; i++) {
+        const struct ConfigOption* option = &set->options[i];
+        size_t field_size = option->type == CONFIG_INT ? sizeof(int) : (size_t)option->max;
+        char* field = (char*)config + option->offset;
+        const char* old_field = (const char*)current + option->offset;
+        int same = option->type == CONFIG_INT ? memcmp(field, old_field, field_size) == 0
+                                              : strcmp(field, old_field) == 0;
+        if (same) {
+            continue;
+        }
+        if (!option->reloadable) {
+            printf("\033[33m%s: zmiana wymaga restartu - pozostaje ", option->key);
+            config_print_value(option, current);
+            printf("\033[0m\n");
+            memcpy(field, old_field, field_size);
+            continue;
+        }
+        printf("\033[33m%s: ", option->key);
+        config_print_value(option, current);
+        printf(" -> ");
+        config_print_value(option, config);
+        printf("\033[0m\n");
+    }
+    return config;
+}
+
+int config_init(struct ConfigSet* set) {
+    void* config = config_load(set, NULL);
+    if (config == NULL) {
+        printf("\033[31mBłędny plik konfiguracji %s\033[0m\n", set->path);
+        return -1;
+    }
+    atomic_store_explicit(&set->current, config, memory_order_release);
+    set->retired = NULL;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = config_signal_handler;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGHUP, &action, NULL) < 0) {
+        perror("Ostrzeżenie: SIGHUP");
+    }
+    return 0;
+}
+
+int config_poll(struct ConfigSet* set) {
+    if (!reload_requested) {
+        return 0;
+    }
+    reload_requested = 0;
+
+    printf("\033[33mPrzeładowanie konfiguracji z %s\033[0m\n", set->path);
+    void* config = config_load(set, config_current(set));
+    if (config == NULL) {
+        printf("\033[31mBłędny plik konfiguracji - zachowano poprzednią\033[0m\n");
+        return 0;
+    }
+
+    // Publikacja jedną zamianą wskaźnika. Poprzednia konfiguracja mogła zostać
+    // pobrana przez czytelnika w tej iteracji, więc jest zwalniana przy następnej zamianie
+    void* previous = atomic_exchange_explicit(&set->current, config, memory_order_acq_rel);
+    free(set->retired);
+    set->retired = previous;
+    return 1;
+}
+
+void config_print(struct ConfigSet* set) {
+    const void* config = config_current(set);
+    printf("Konfiguracja (%s):\n", set->path);
+    for (int i = 0; i < set->option_count; i++) {
+        printf("  %s = ", set->options[i].key);
+        config_print_value(&set->options[i], config);
+        printf("%s\n", set->options[i].reloadable ? "" : "  (tylko przy starcie)");
+    }
+}
+
+void config_destroy(struct ConfigSet* set) {
+    free(atomic_exchange(&set->current, NULL));
+    free(set->retired);
+    set->retired = NULL;
+}
@@ -0,0 +1,65 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Konfiguracja w czasie działania - plik tekstowy "klucz = wartość" (komentarze od '#').
+// Używana przez serwer i klienta; wartości domyślne pochodzą ze stałych kompilacji.
+//
+// Przeładowanie bez restartu: SIGHUP ustawia flagę, a pętla główna w bezpiecznym
+// miejscu (między partiami pakietów) wczytuje plik do nowej struktury i publikuje ją
+// jedną atomową zamianą wskaźnika. Czytelnicy pobierają wskaźnik przez config_current()
+// przy każdym użyciu i nie przechowują go między iteracjami pętli - poprzednia struktura
+// jest zwalniana dopiero przy następnym przeładowaniu.
+// Błędny plik (nieznany klucz, wartość spoza zakresu) nie zmienia bieżącej konfiguracji.
+
+#define CONFIG_MAX_LINE 256
+
+enum ConfigType {
+    CONFIG_INT,                 // int w zakresie [min, max]
+    CONFIG_STRING               // char[max] - napis krótszy niż max bajtów
+};
+
+// Opis jednego klucza pliku konfiguracyjnego
+struct ConfigOption {
+    const char* key;            // Nazwa w pliku
+    enum ConfigType type;
+    size_t offset;              // Położenie pola w strukturze konfiguracji (offsetof)
+    int min;                    // CONFIG_INT: najmniejsza wartość
+    int max;                    // CONFIG_INT: największa wartość, CONFIG_STRING: rozmiar pola
+    int reloadable;             // 0 = zmiana działa dopiero po restarcie (np. port gniazda)
+};
+
+// Zestaw konfiguracji jednego programu
+struct ConfigSet {
+    const char* path;                   // Plik konfiguracyjny (brak pliku = wartości domyślne)
+    const struct ConfigOption* options;
+    int option_count;
+    const void* defaults;               // Struktura z wartościami domyślnymi
+    size_t size;                        // Rozmiar struktury konfiguracji
+    int (*validate)(const void* config);// Sprawdzenie zależności między kluczami (0 albo -1), może być NULL
+    _Atomic(void*) current;             // Opublikowana konfiguracja
+    void* retired;                      // Poprzednia konfiguracja (zwalniana przy kolejnej zamianie)
+};
+
+// Wczytuje konfigurację przy starcie i instaluje obsługę SIGHUP.
+// Zwraca 0 albo -1, gdy plik istnieje, ale jest błędny
+int config_init(struct ConfigSet* set);
+
+// Zwraca bieżącą konfigurację (wskaźnik na strukturę programu)
+static inline const void* config_current(struct ConfigSet* set) {
+    return atomic_load_explicit(&set->current, memory_order_acquire);
+}
+
+// Sprawdza, czy przyszedł SIGHUP, i jeśli tak - przeładowuje plik.
+// Zwraca 1, gdy opublikowano nową konfigurację, 0 w przeciwnym razie
+int config_poll(struct ConfigSet* set);
+
+// Wypisuje wszystkie klucze z bieżącymi wartościami
+void config_print(struct ConfigSet* set);
+
+// Zwalnia konfigurację przy zakończeniu programu
+void config_destroy(struct ConfigSet* set);
+
+#endif
@@ -0,0 +1,37 @@
+#include "frame.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "udp.h"            // Dla send_datagram()
+
+void frame_init(struct PackedFrame* frame) {
+    frame->data[0] = PARSE_PACKED;
+    frame->length = 1;
+    frame->count = 0;
+}
+
+int frame_append(struct PackedFrame* frame, const char* data, size_t length) {
+    if (length == 0 || length > PACK_MAX_MESSAGE || frame->length + 1 + length > PACK_MTU) {
+        return 0;
+    }
+    frame->data[frame->length] = (char)length;
+    memcpy(frame->data + frame->length + 1, data, length);
+    frame->length += 1 + length;
+    frame->count++;
+    return 1;
+}
+
+void frame_send(int sock, struct PackedFrame* frame, struct sockaddr_in* addr) {
+    if (frame->count == 0) {
+        return;
+    }
+    if (frame->count == 1) {
+        send_datagram(sock, frame->data + 2, (unsigned char)frame->data[1], addr);
+    } else {
+        printf("\033[34mWysyłanie ramki zbiorczej: %d wiadomości, %d B\033[0m\n",
+               frame->count, frame->length);
+        send_datagram(sock, frame->data, frame->length, addr);
+    }
+    frame_init(frame);
+}
@@ -0,0 +1,52 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stddef.h>
+#include <netinet/in.h>     // Dla struct sockaddr_in
+
+#include "parse.h"          // Dla PARSE_PACKED - nagłówka ramki
+
+// Ramka zbiorcza - kilka wiadomości protokołu w jednym datagramie UDP.
+// Używana przez klienta (PING i REQUEST do jednego serwera) i serwer (odpowiedzi na ramkę).
+//
+// Układ: [PACKED][dł.1][wiadomość 1][dł.2][wiadomość 2]... (długość na jednym bajcie)
+// Ramka z jedną wiadomością jest wysyłana jako zwykły datagram, bez nagłówka ramki.
+
+#define PACK_MTU 1472               // Maksymalny rozmiar ramki (MTU Ethernet - nagłówki IP i UDP)
+#define PACK_MAX_MESSAGE 255        // Maksymalna długość jednej wiadomości w ramce
+
+// Ramka zbiorcza w budowie
+struct PackedFrame {
+    char data[PACK_MTU];        // Nagłówek PACKED i kolejne wiadomości z długościami
+    int length;                 // Zajęte bajty (razem z nagłówkiem)
+    int count;                  // Liczba wiadomości w ramce
+};
+
+// Przygotowuje pustą ramkę
+void frame_init(struct PackedFrame* frame);
+
+// Dopisuje wiadomość do ramki. Zwraca 1 albo 0, gdy wiadomość się nie mieści
+int frame_append(struct PackedFrame* frame, const char* data, size_t length);
+
+// Wysyła ramkę (send_datagram) i czyści ją. Pusta ramka nie jest wysyłana
+void frame_send(int sock, struct PackedFrame* frame, struct sockaddr_in* addr);
+
+// Pobiera kolejną wiadomość z odebranej ramki. offset - pozycja w ramce, przed pierwszym
+// wywołaniem równa 1 (za nagłówkiem), przesuwana za zwróconą wiadomość.
+// Zwraca 1 i ustawia message/message_length, 0 na końcu ramki albo -1 dla uszkodzonej długości
+static inline int frame_next(const char* data, int length, int* offset,
+                             const char** message, int* message_length) {
+    if (*offset >= length) {
+        return 0;
+    }
+    int next_length = (unsigned char)data[*offset];
+    if (next_length == 0 || *offset + 1 + next_length > length) {
+        return -1;
+    }
+    *message = data + *offset + 1;
+    *message_length = next_length;
+    *offset += 1 + next_length;
+    return 1;
+}
+
+#endif
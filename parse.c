@@ -0,0 +1,242 @@
+#include "parse.h"
+#include "frame.h"          // Dla frame_next() - układ ramki zbiorczej
+
+#include <limits.h>
+
+#if PARSE_SIMD && defined(__x86_64__) && defined(__GNUC__)
+#define PARSE_X86 1
+#include <immintrin.h>      // SSE2 (zawsze na x86-64) i AVX2 (sprawdzane przy starcie)
+#else
+#define PARSE_X86 0
+#endif
+
+// Funkcja sprawdzająca, czy wszystkie bajty mieszczą się w zakresie [lo, hi].
+// lo i hi muszą leżeć w 0x01..0x7E - bajty >= 0x80 są wtedy zawsze poza zakresem.
+// Zwraca 1 gdy wszystkie bajty są w zakresie, 0 w przeciwnym razie
+typedef int (*scan_fn)(const char* data, int length, char lo, char hi);
+
+static int scan_scalar(const char* data, int length, char lo, char hi) {
+    for (int i = 0; i < length; i++) {
+        if (data[i] < lo || data[i] > hi) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#if PARSE_X86
+// Wersja SSE2: 16 bajtów na porównanie. Porównania są ze znakiem, więc bajty >= 0x80
+// (ujemne) nie przechodzą testu > lo - 1. Ostatni blok czyta zapas PARSE_PADDING,
+// a bajty za danymi są wycinane z maski
+static int scan_sse2(const char* data, int length, char lo, char hi) {
+    __m128i below = _mm_set1_epi8(lo - 1);
+    __m128i above = _mm_set1_epi8(hi + 1);
+
+    for (int offset = 0; offset < length; offset += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + offset));
+        __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(block, below),
+                                         _mm_cmplt_epi8(block, above));
+        unsigned int bad = ~(unsigned int)_mm_movemask_epi8(in_range) & 0xFFFFu;
+        if (length - offset < 16) {
+            bad &= (1u << (length - offset)) - 1;
+        }
+        if (bad != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Wersja AVX2: 32 bajty na porównanie, kompilowana niezależnie od flag -m
+__attribute__((target("avx2")))
+static int scan_avx2(const char* data, int length, char lo, char hi) {
+    __m256i below = _mm256_set1_epi8(lo - 1);
+    __m256i above = _mm256_set1_epi8(hi + 1);
+
+    for (int offset = 0; offset < length; offset += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(data + offset));
+        __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi8(block, below),
+                                            _mm256_cmpgt_epi8(above, block));
+        unsigned int bad = ~(unsigned int)_mm256_movemask_epi8(in_range);
+        if (length - offset < 32) {
+            bad &= (1u << (length - offset)) - 1;
+        }
+        if (bad != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+// Wybrana implementacja - do wywołania parse_init() działa wersja skalarna
+static scan_fn scan_range = scan_scalar;
+static const char* scan_name = "skalarna";
+
+void parse_init() {
+    if (parse_select(PARSE_AVX2) < 0 && parse_select(PARSE_SSE2) < 0) {
+        parse_select(PARSE_SCALAR);
+    }
+}
+
+int parse_select(enum ParseImplementation implementation) {
+    switch (implementation) {
+        case PARSE_SCALAR:
+            scan_range = scan_scalar;
+            scan_name = "skalarna";
+            return 0;
+#if PARSE_X86
+        case PARSE_SSE2:
+            scan_range = scan_sse2;
+            scan_name = "SSE2";
+            return 0;
+        case PARSE_AVX2:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx2")) {
+                return -1;
+            }
+            scan_range = scan_avx2;
+            scan_name = "AVX2";
+            return 0;
+#endif
+        default:
+            return -1;
+    }
+}
+
+const char* parse_implementation() {
+    return scan_name;
+}
+
+int parse_decimal(const char* data, int length, int* value) {
+    int negative = length > 0 && data[0] == '-';
+    const char* digits = data + negative;
+    int digit_count = length - negative;
+
+    // int ma najwyżej 10 cyfr
+    if (digit_count < 1 || digit_count > 10 || !scan_range(digits, digit_count, '0', '9')) {
+        return -1;
+    }
+
+    long long result = 0;
+    for (int i = 0; i < digit_count; i++) {
+        result = result * 10 + (digits[i] - '0');
+    }
+    if (negative) {
+        result = -result;
+    }
+    if (result < INT_MIN || result > INT_MAX) {
+        return -1;
+    }
+
+    *value = (int)result;
+    return 0;
+}
+
+int parse_epoch(const char* data, int length, unsigned int* value) {
+    // unsigned int ma najwyżej 10 cyfr
+    if (length < 1 || length > 10 || !scan_range(data, length, '0', '9')) {
+        return -1;
+    }
+
+    unsigned long long result = 0;
+    for (int i = 0; i < length; i++) {
+        result = result * 10 + (data[i] - '0');
+    }
+    if (result > UINT_MAX) {
+        return -1;
+    }
+
+    *value = (unsigned int)result;
+    return 0;
+}
+
+int parse_hello(const char* data, int length, int* server_id, int* liveness_port) {
+    int id_length = 0;
+    while (id_length < length && data[id_length] != ':') {
+        id_length++;
+    }
+    if (parse_decimal(data, id_length, server_id) < 0) {
+        return -1;
+    }
+
+    *liveness_port = 0;
+    if (id_length < length &&
+        (parse_decimal(data + id_length + 1, length - id_length - 1, liveness_port) < 0 ||
+         *liveness_port < 1 || *liveness_port > 65535)) {
+        return -1;
+    }
+    return 0;
+}
+
+int parse_message(const char* data, int length, struct ParsedMessage* parsed) {
+    if (length < 1 || length > PARSE_MAX_LENGTH) {
+        return -1;
+    }
+
+    const char* body = data + 1;
+    int body_length = length - 1;
+    int value, port;
+    unsigned int epoch;
+
+    switch (data[0]) {
+        case PARSE_HELLO:
+            if (parse_hello(body, body_length, &value, &port) < 0) {
+                return -1;
+            }
+            break;
+        case PARSE_REQUEST:
+        case PARSE_RESPONSE:
+            // Epoka jest opcjonalna ("q" albo "q42")
+            if (body_length > 0 && parse_epoch(body, body_length, &epoch) < 0) {
+                return -1;
+            }
+            break;
+        case PARSE_PING:
+        case PARSE_PONG:
+            if (body_length == 0 || !scan_range(body, body_length, ' ', '~')) {
+                return -1;
+            }
+            break;
+        default:
+            return -1;
+    }
+
+    parsed->type = data[0];
+    parsed->body = body;
+    parsed->body_length = body_length;
+    return 0;
+}
+
+int parse_packed_frame(const char* data, int length) {
+    if (length < 1 || data[0] != PARSE_PACKED) {
+        return -1;
+    }
+
+    int count = 0;
+    int offset = 1;
+    const char* message;
+    int message_length;
+    int result;
+    while ((result = frame_next(data, length, &offset, &message, &message_length)) > 0) {
+        struct ParsedMessage parsed;
+        if (parse_message(message, message_length, &parsed) < 0) {
+            return -1;
+        }
+        count++;
+    }
+
+    return result == 0 && count > 0 ? count : -1;
+}
+
+char parse_classify(const char* data, int length) {
+    if (length > 0 && data[0] == PARSE_PACKED) {
+        return parse_packed_frame(data, length) > 0 ? PARSE_PACKED : 0;
+    }
+
+    struct ParsedMessage parsed;
+    if (parse_message(data, length, &parsed) < 0) {
+        return 0;
+    }
+    return parsed.type;
+}
@@ -0,0 +1,81 @@
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stddef.h>
+
+// Walidacja i klasyfikacja odebranych wiadomości protokołu tekstowego.
+// Używana przez serwer i klienta zanim wiadomość trafi do obsługi.
+//
+// Treść wiadomości jest sprawdzana wektorowo (AVX2 albo SSE2, wybór przy starcie
+// w parse_init()), z wersją skalarną dla innych procesorów i dla -DPARSE_SIMD=0.
+// Sprawdzanie czyta całe bloki 16/32 bajtów, więc za danymi musi być PARSE_PADDING
+// bajtów bufora do odczytu (ich zawartość nie ma znaczenia).
+
+#ifndef PARSE_SIMD
+#define PARSE_SIMD 1            // 0 = tylko wersja skalarna (porównania wydajności)
+#endif
+#define PARSE_PADDING 32        // Wymagany zapas bufora za danymi (jeden blok AVX2)
+#define PARSE_MAX_LENGTH 1023   // Najdłuższa poprawna wiadomość (BUFFER_SIZE - 1)
+
+// Nagłówki protokołu (te same co w server.c i client.c)
+#define PARSE_HELLO 'h'
+#define PARSE_PING 'i'
+#define PARSE_PONG 'o'
+#define PARSE_REQUEST 'q'
+#define PARSE_RESPONSE 's'
+#define PARSE_PACKED 'p'
+
+// Wynik klasyfikacji pojedynczej wiadomości (nie ramki zbiorczej)
+struct ParsedMessage {
+    char type;                  // Nagłówek wiadomości
+    const char* body;           // Treść za nagłówkiem (wskazuje do bufora wejściowego)
+    int body_length;            // Długość treści
+};
+
+// Implementacje sprawdzania treści wiadomości
+enum ParseImplementation {
+    PARSE_SCALAR,
+    PARSE_SSE2,
+    PARSE_AVX2
+};
+
+// Wybiera implementację (AVX2/SSE2/skalarna) zależnie od procesora
+void parse_init();
+
+// Wymusza implementację (porównania w parse_bench). Zwraca 0 albo -1, gdy procesor
+// albo kompilacja (-DPARSE_SIMD=0, inna architektura niż x86-64) jej nie obsługuje
+int parse_select(enum ParseImplementation implementation);
+
+// Zwraca nazwę wybranej implementacji (do komunikatu przy starcie)
+const char* parse_implementation();
+
+// Sprawdza pojedynczą wiadomość:
+// - znany nagłówek (innych niż PARSE_PACKED)
+// - HELLO: niepuste ID dziesiętne (opcjonalny '-') i opcjonalnie ':' z portem aktywności,
+//   REQUEST/RESPONSE: epoka dziesiętna bez znaku (32 bity, jak licznik klienta) albo nic
+// - PING/PONG: niepusta treść z drukowalnych znaków ASCII
+// Zwraca 0 i wypełnia parsed albo -1 dla wiadomości niepoprawnej
+int parse_message(const char* data, int length, struct ParsedMessage* parsed);
+
+// Sprawdza ramkę zbiorczą [PACKED][dł.1][wiadomość 1]... - długości i każdą wiadomość.
+// Zwraca liczbę wiadomości albo -1 dla ramki niepoprawnej
+int parse_packed_frame(const char* data, int length);
+
+// Klasyfikuje odebrany datagram (pojedynczą wiadomość albo ramkę zbiorczą).
+// Zwraca nagłówek poprawnego datagramu albo 0 dla niepoprawnego
+char parse_classify(const char* data, int length);
+
+// Parsuje liczbę dziesiętną (opcjonalny '-', same cyfry, bez przepełnienia int).
+// Zwraca 0 i zapisuje wynik w value albo -1
+int parse_decimal(const char* data, int length, int* value);
+
+// Parsuje epokę REQUEST/RESPONSE - liczbę bez znaku do UINT_MAX (same cyfry).
+// Klient liczy epoki w unsigned int, więc po 2^31 rundach nadal są poprawne, a po UINT_MAX wracają do 0.
+// Zwraca 0 i zapisuje wynik w value albo -1
+int parse_epoch(const char* data, int length, unsigned int* value);
+
+// Parsuje treść HELLO: "<id>" albo "<id>:<port_aktywności>" (osobne gniazdo serwera na REQUEST).
+// Zwraca 0 i zapisuje ID oraz port (0, gdy go nie ma) albo -1
+int parse_hello(const char* data, int length, int* server_id, int* liveness_port);
+
+#endif
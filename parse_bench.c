@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>           // Dla clock_gettime()
+
+#include "parse.h"
+
+// Porównanie i test równoważności warstwy parse.c:
+// 1. fuzz - losowe datagramy (cyfry, litery, bajty binarne, ramki zbiorcze z uszkodzeniami)
+//    przez wszystkie dostępne implementacje; wynik każdej musi być taki sam jak skalarnej,
+//    a parse_decimal i parse_epoch muszą zgadzać się z strtoll(); do tego przypadki
+//    graniczne epok REQUEST/RESPONSE (2^31 - klient liczy epoki bez znaku, UINT_MAX, 2^32)
+// 2. wydajność - czas na datagram starej ścieżki odbioru (zakończenie zerem, switch,
+//    malloc + strcpy, sscanf/atoi, bez żadnej walidacji) i nowej (parse_message,
+//    parse_hello/parse_epoch) dla każdej implementacji, osobno dla krótkich wiadomości
+//    i dla PONGów po 1 KB. Implementacja wolniejsza od starej ścieżki jest wypisywana
+//    na żółto - tak wygląda wersja skalarna (-DPARSE_SIMD=0, procesory spoza x86-64)
+//    przy długich wiadomościach.
+//
+//   make bench                  - 1M datagramów fuzz, 2M datagramów na pomiar
+//   ./parse_bench 10000000      - dłuższy fuzz
+
+#define BUFFER_SIZE 1024            // Jak bufor odbiorczy serwera i klienta
+#define DEFAULT_FUZZ_COUNT 1000000  // Datagramy testu równoważności
+#define DECIMAL_FUZZ_COUNT 1000000  // Napisy testu parse_decimal
+#define BENCH_COUNT 2000000         // Datagramy na jeden pomiar
+#define BENCH_MIX 64                // Datagramy w zestawie pomiarowym (powtarzanym w kółko)
+#define LONG_PONG_LENGTH 1000       // Treść długiego PONGa
+
+static const enum ParseImplementation implementations[] = {PARSE_SCALAR, PARSE_SSE2, PARSE_AVX2};
+#define IMPLEMENTATION_COUNT 3
+
+// Datagram z zapasem PARSE_PADDING za danymi (jak bufory odbiorcze)
+struct Datagram {
+    char data[BUFFER_SIZE + PARSE_PADDING];
+    int length;
+};
+
+// Wynik parsowania jednego datagramu - porównywany między implementacjami
+struct ParseResult {
+    char classified;
+    int message_result;
+    char type;
+    int body_length;
+    int frame_count;
+};
+
+static unsigned long long monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static char random_char(const char* alphabet) {
+    return alphabet[rand() % strlen(alphabet)];
+}
+
+// Wypełnia bufor losową treścią jednego z kilku rodzajów
+static void random_body(char* data, int length) {
+    int kind = rand() % 5;
+    for (int i = 0; i < length; i++) {
+        switch (kind) {
+            case 0: data[i] = random_char("0123456789"); break;
+            case 1: data[i] = random_char("-0123456789:"); break;
+            case 2: data[i] = ' ' + rand() % 95; break;            // Drukowalne ASCII
+            case 3: data[i] = (char)(rand() % 256); break;          // Dowolne bajty
+            default: data[i] = rand() % 50 == 0 ? (char)(rand() % 256) : 'a' + rand() % 26;
+        }
+    }
+}
+
+// Losowy datagram: pojedyncza wiadomość albo ramka zbiorcza (czasem uszkodzona)
+static void random_datagram(struct Datagram* datagram) {
+    static const char headers[] = "hioqspx";
+    memset(datagram->data, rand() % 256, sizeof(datagram->data));  // Śmieci w zapasie
+
+    if (rand() % 4 != 0) {
+        int length = 1 + (rand() % 8 == 0 ? rand() % BUFFER_SIZE : rand() % 40);
+        datagram->data[0] = headers[rand() % (sizeof(headers) - 1)];
+        random_body(datagram->data + 1, length - 1);
+        datagram->length = length;
+        return;
+    }
+
+    datagram->data[0] = PARSE_PACKED;
+    int length = 1;
+    int messages = 1 + rand() % 6;
+    for (int m = 0; m < messages; m++) {
+        int message_length = 1 + rand() % 30;
+        if (length + 1 + message_length > BUFFER_SIZE) {
+            break;
+        }
+        datagram->data[length] = (char)message_length;
+        datagram->data[length + 1] = headers[rand() % 5];
+        random_body(datagram->data + length + 2, message_length - 1);
+        length += 1 + message_length;
+    }
+    if (rand() % 4 == 0) {
+        length -= rand() % length;                                  // Ucięta ramka
+    } else if (rand() % 4 == 0 && length > 1) {
+        datagram->data[1 + rand() % (length - 1)] = (char)(rand() % 256);  // Uszkodzony bajt
+    }
+    datagram->length = length;
+}
+
+static void parse_all(const struct Datagram* datagram, struct ParseResult* result) {
+    struct ParsedMessage parsed;
+    memset(result, 0, sizeof(*result));
+    result->classified = parse_classify(datagram->data, datagram->length);
+    result->message_result = parse_message(datagram->data, datagram->length, &parsed);
+    if (result->message_result == 0) {
+        result->type = parsed.type;
+        result->body_length = parsed.body_length;
+    }
+    result->frame_count = parse_packed_frame(datagram->data, datagram->length);
+}
+
+// Test równoważności implementacji. Zwraca liczbę rozbieżności
+static unsigned long fuzz_implementations(unsigned long count) {
+    unsigned long mismatches = 0, valid = 0;
+    struct Datagram datagram;
+
+    for (unsigned long n = 0; n < count; n++) {
+        random_datagram(&datagram);
+        struct ParseResult expected, actual;
+        parse_select(PARSE_SCALAR);
+        parse_all(&datagram, &expected);
+        valid += expected.classified != 0;
+
+        for (int i = 1; i < IMPLEMENTATION_COUNT; i++) {
+            if (parse_select(implementations[i]) < 0) {
+                continue;
+            }
+            parse_all(&datagram, &actual);
+            if (expected.classified != actual.classified ||
+                expected.message_result != actual.message_result ||
+                expected.type != actual.type || expected.body_length != actual.body_length ||
+                expected.frame_count != actual.frame_count) {
+                if (mismatches++ < 10) {
+                    printf("\033[31mRozbieżność %s: datagram '%c' długość %d\033[0m\n",
+                           parse_implementation(), datagram.data[0], datagram.length);
+                }
+            }
+        }
+    }
+
+    printf("Fuzz implementacji: %lu datagramów (poprawnych %lu), rozbieżności: %lu\n",
+           count, valid, mismatches);
+    return mismatches;
+}
+
+// Porównanie parse_decimal i parse_epoch z strtoll() na napisach z cyfr i '-'.
+// Zwraca liczbę rozbieżności
+static unsigned long fuzz_decimal(unsigned long count) {
+    unsigned long mismatches = 0;
+    char text[16 + PARSE_PADDING];
+
+    for (unsigned long n = 0; n < count; n++) {
+        int length = rand() % 13;
+        memset(text, 0, sizeof(text));
+        for (int i = 0; i < length; i++) {
+            text[i] = rand() % 12 == 0 ? '-' : rand() % 40 == 0 ? 'x' : random_char("0123456789");
+        }
+
+        // Poprawna: strtoll zjada cały napis, najwyżej 10 cyfr, wynik mieści się w int
+        char* end;
+        errno = 0;
+        long long reference = length > 0 ? strtoll(text, &end, 10) : 0;
+        int digits = length - (text[0] == '-');
+        int expected_valid = length > 0 && end == text + length && errno == 0 &&
+                             digits >= 1 && digits <= 10 &&
+                             reference >= INT_MIN && reference <= INT_MAX;
+        // Epoka: bez '-', najwyżej 10 cyfr, wynik mieści się w unsigned int
+        int expected_epoch_valid = length > 0 && end == text + length && text[0] != '-' &&
+                                   length <= 10 && reference <= UINT_MAX;
+
+        for (int i = 0; i < IMPLEMENTATION_COUNT; i++) {
+            if (parse_select(implementations[i]) < 0) {
+                continue;
+            }
+            int value;
+            int valid = parse_decimal(text, length, &value) == 0;
+            if (valid != expected_valid || (valid && value != reference)) {
+                if (mismatches++ < 10) {
+                    printf("\033[31mRozbieżność parse_decimal (%s): '%s'\033[0m\n",
+                           parse_implementation(), text);
+                }
+            }
+            unsigned int epoch;
+            int epoch_valid = parse_epoch(text, length, &epoch) == 0;
+            if (epoch_valid != expected_epoch_valid || (epoch_valid && epoch != reference)) {
+                if (mismatches++ < 10) {
+                    printf("\033[31mRozbieżność parse_epoch (%s): '%s'\033[0m\n",
+                           parse_implementation(), text);
+                }
+            }
+        }
+    }
+
+    printf("Fuzz parse_decimal/parse_epoch: %lu napisów, rozbieżności ze strtoll: %lu\n",
+           count, mismatches);
+    return mismatches;
+}
+
+// Przypadki graniczne epok w REQUEST/RESPONSE. Zwraca liczbę błędów
+static unsigned long check_epoch_boundaries() {
+    static const struct {
+        const char* message;
+        char expected;          // Wynik parse_classify (0 = odrzucony)
+    } cases[] = {
+        {"q", PARSE_REQUEST},
+        {"q0", PARSE_REQUEST},
+        {"q2147483647", PARSE_REQUEST},     // INT_MAX
+        {"q2147483648", PARSE_REQUEST},     // 2^31 - następna runda po INT_MAX
+        {"s3000000000", PARSE_RESPONSE},
+        {"q4294967295", PARSE_REQUEST},     // UINT_MAX - potem licznik wraca do 0
+        {"q4294967296", 0},                 // 2^32 - poza unsigned int
+        {"q10000000000", 0},                // 11 cyfr
+        {"q-1", 0},
+        {"q+1", 0},
+    };
+    unsigned long errors = 0;
+    char data[32 + PARSE_PADDING];
+
+    for (int i = 0; i < IMPLEMENTATION_COUNT; i++) {
+        if (parse_select(implementations[i]) < 0) {
+            continue;
+        }
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            memset(data, 0, sizeof(data));
+            int length = (int)strlen(cases[c].message);
+            memcpy(data, cases[c].message, length);
+            char classified = parse_classify(data, length);
+            if (classified != cases[c].expected) {
+                errors++;
+                printf("\033[31mEpoka (%s): '%s' - oczekiwano %s\033[0m\n", parse_implementation(),
+                       cases[c].message, cases[c].expected ? "poprawnej" : "odrzucenia");
+            }
+        }
+    }
+
+    printf("Epoki graniczne: %zu przypadków, błędy: %lu\n", sizeof(cases) / sizeof(cases[0]), errors);
+    return errors;
+}
+
+// Stara ścieżka odbioru: zakończenie zerem, switch na pierwszym bajcie,
+// kopia treści do bufora z malloc(), sscanf() dla HELLO i atoi() dla epoki
+static int old_path(struct Datagram* datagram) {
+    datagram->data[datagram->length] = '\0';
+    char* message = malloc(BUFFER_SIZE);
+    strcpy(message, datagram->data + 1);
+
+    int result = 0;
+    switch (datagram->data[0]) {
+        case PARSE_HELLO:
+            sscanf(message, "%d", &result);
+            break;
+        case PARSE_RESPONSE:
+            if (message[0] != '\0') {
+                result = atoi(message);
+            }
+            break;
+        case PARSE_PING:
+        case PARSE_PONG:
+            result = (int)strlen(message);
+            break;
+    }
+    free(message);
+    return result;
+}
+
+// Nowa ścieżka: walidacja i klasyfikacja, potem liczby bez sscanf
+static int new_path(struct Datagram* datagram) {
+    struct ParsedMessage parsed;
+    if (parse_message(datagram->data, datagram->length, &parsed) < 0) {
+        return -1;
+    }
+
+    int result = 0, port;
+    switch (parsed.type) {
+        case PARSE_HELLO:
+            parse_hello(parsed.body, parsed.body_length, &result, &port);
+            break;
+        case PARSE_RESPONSE:
+            if (parsed.body_length > 0) {
+                unsigned int epoch;
+                parse_epoch(parsed.body, parsed.body_length, &epoch);
+                result = (int)epoch;
+            }
+            break;
+        default:
+            result = parsed.body_length;
+    }
+    return result;
+}
+
+// Zestaw pomiarowy: co trzeci datagram to PONG o podanej długości treści, reszta HELLO i RESPONSE
+static void build_mix(struct Datagram* mix, int pong_length) {
+    for (int i = 0; i < BENCH_MIX; i++) {
+        struct Datagram* datagram = &mix[i];
+        memset(datagram->data, 0, sizeof(datagram->data));
+        switch (i % 3) {
+            case 0:
+                datagram->data[0] = PARSE_PONG;
+                for (int j = 1; j <= pong_length; j++) {
+                    datagram->data[j] = 'a' + (i + j) % 26;
+                }
+                datagram->length = 1 + pong_length;
+                break;
+            case 1:
+                datagram->length = sprintf(datagram->data, "%c%d:%d", PARSE_HELLO, 1000 + i, 2306);
+                break;
+            default:
+                datagram->length = sprintf(datagram->data, "%c%d", PARSE_RESPONSE, 40000 + i);
+        }
+    }
+}
+
+// Zwraca średni czas na datagram w nanosekundach
+static double measure(struct Datagram* mix, int (*path)(struct Datagram*), long long* sink) {
+    unsigned long long start = monotonic_ns();
+    for (int n = 0; n < BENCH_COUNT; n++) {
+        *sink += path(&mix[n % BENCH_MIX]);
+    }
+    return (double)(monotonic_ns() - start) / BENCH_COUNT;
+}
+
+static void bench_mix(const char* name, int pong_length) {
+    static struct Datagram mix[BENCH_MIX];
+    long long sink = 0;
+    build_mix(mix, pong_length);
+
+    // Rozgrzewka, potem pomiar
+    measure(mix, old_path, &sink);
+    double old_ns = measure(mix, old_path, &sink);
+    printf("%s:\n", name);
+    printf("  stara ścieżka (bez walidacji):  %7.1f ns/datagram\n", old_ns);
+
+    for (int i = 0; i < IMPLEMENTATION_COUNT; i++) {
+        if (parse_select(implementations[i]) < 0) {
+            printf("  %-8s                        niedostępna\n",
+                   implementations[i] == PARSE_SSE2 ? "SSE2" : "AVX2");
+            continue;
+        }
+        measure(mix, new_path, &sink);
+        double new_ns = measure(mix, new_path, &sink);
+        if (new_ns > old_ns) {
+            printf("\033[33m  %-8s                      %7.1f ns/datagram - %.1fx wolniej niż stara ścieżka\033[0m\n",
+                   parse_implementation(), new_ns, new_ns / old_ns);
+        } else {
+            printf("  %-8s                      %7.1f ns/datagram\n", parse_implementation(), new_ns);
+        }
+    }
+    if (sink == 42) {
+        printf("\n");   // Wynik musi być użyty, inaczej kompilator usunie pętle
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long fuzz_count = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_FUZZ_COUNT;
+    if (fuzz_count == 0) {
+        printf("Użycie: %s [liczba_datagramów_fuzz]\n", argv[0]);
+        return 1;
+    }
+    srand(1);
+
+    parse_init();
+    printf("Implementacja domyślna: %s\n", parse_implementation());
+
+    unsigned long mismatches = fuzz_implementations(fuzz_count);
+    mismatches += fuzz_decimal(DECIMAL_FUZZ_COUNT);
+    mismatches += check_epoch_boundaries();
+
+    bench_mix("Krótkie wiadomości (PONG 15 B, HELLO, RESPONSE)", 14);
+    bench_mix("Długie PONGi (1 KB, HELLO, RESPONSE)", LONG_PONG_LENGTH);
+
+    if (mismatches > 0) {
+        printf("\033[31mParsowanie: %lu rozbieżności\033[0m\n", mismatches);
+        return 1;
+    }
+    printf("\033[32mParsowanie: implementacje zgodne\033[0m\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Nagłówek płyty - za nim slab_objects obiektów
+struct PoolSlab {
+    struct PoolSlab* next;
+    char padding[POOL_ALIGN - sizeof(struct PoolSlab*)];
+};
+
+// Podręczna lista wolnych obiektów jednego wątku dla jednej puli
+struct PoolCache {
+    void* objects[POOL_CACHE_SIZE];
+    int count;
+};
+
+static _Thread_local struct PoolCache pool_caches[POOL_MAX_POOLS];
+static atomic_int pool_count = 0;
+
+static void pool_lock(struct Pool* pool) {
+    while (atomic_flag_test_and_set_explicit(&pool->lock, memory_order_acquire)) {
+        // Sekcje krytyczne są krótkie (kilka wskaźników) - aktywne czekanie
+    }
+}
+
+static void pool_unlock(struct Pool* pool) {
+    atomic_flag_clear_explicit(&pool->lock, memory_order_release);
+}
+
+// Funkcja przydzielająca nową płytę i dopinająca jej obiekty do wspólnej listy.
+// Wywoływana pod blokadą.
+static int pool_grow(struct Pool* pool) {
+    struct PoolSlab* slab = malloc(sizeof(struct PoolSlab) + pool->object_size * pool->slab_objects);
+    if (slab == NULL) {
+        printf("\033[31mPula %s: brak pamięci na nową płytę\033[0m\n", pool->name);
+        return -1;
+    }
+    atomic_fetch_add(&pool->system_allocs, 1);
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    char* objects = (char*)(slab + 1);
+    for (size_t i = 0; i < pool->slab_objects; i++) {
+        void* object = objects + i * pool->object_size;
+        *(void**)object = pool->free_list;
+        pool->free_list = object;
+    }
+
+    // Wzrost puli w stanie ustalonym oznacza wyciek albo za małą płytę
+    printf("\033[33mPula %s: nowa płyta (%zu obiektów po %zu B, płyt: %lu, w użyciu: %ld)\033[0m\n",
+           pool->name, pool->slab_objects, pool->object_size,
+           atomic_load(&pool->system_allocs), atomic_load(&pool->in_use));
+    return 0;
+}
+
+int pool_init(struct Pool* pool, const char* name, size_t object_size, size_t slab_objects) {
+    int id = atomic_fetch_add(&pool_count, 1);
+    if (id >= POOL_MAX_POOLS) {
+        printf("\033[31mPula %s: przekroczono POOL_MAX_POOLS\033[0m\n", name);
+        return -1;
+    }
+
+    if (object_size < sizeof(void*)) {
+        object_size = sizeof(void*);
+    }
+    pool->name = name;
+    pool->object_size = (object_size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    pool->slab_objects = slab_objects;
+    pool->id = id;
+    atomic_flag_clear(&pool->lock);
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    atomic_init(&pool->allocs, 0);
+    atomic_init(&pool->frees, 0);
+    atomic_init(&pool->system_allocs, 0);
+    atomic_init(&pool->refills, 0);
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->peak_in_use, 0);
+
+    pool_lock(pool);
+    int result = pool_grow(pool);
+    pool_unlock(pool);
+    return result;
+}
+
+void* pool_alloc(struct Pool* pool) {
+    struct PoolCache* cache = &pool_caches[pool->id];
+
+    // Pusta podręczna lista - pobranie połowy pojemności ze wspólnej listy
+    if (cache->count == 0) {
+        pool_lock(pool);
+        while (cache->count < POOL_CACHE_SIZE / 2) {
+            if (pool->free_list == NULL && pool_grow(pool) < 0) {
+                break;
+            }
+            void* object = pool->free_list;
+            pool->free_list = *(void**)object;
+            cache->objects[cache->count++] = object;
+        }
+        pool_unlock(pool);
+        atomic_fetch_add_explicit(&pool->refills, 1, memory_order_relaxed);
+        if (cache->count == 0) {
+            return NULL;
+        }
+    }
+
+    atomic_fetch_add_explicit(&pool->allocs, 1, memory_order_relaxed);
+    long in_use = atomic_fetch_add_explicit(&pool->in_use, 1, memory_order_relaxed) + 1;
+    long peak = atomic_load_explicit(&pool->peak_in_use, memory_order_relaxed);
+    while (in_use > peak &&
+           !atomic_compare_exchange_weak_explicit(&pool->peak_in_use, &peak, in_use,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    return cache->objects[--cache->count];
+}
+
+void pool_free(struct Pool* pool, void* object) {
+    if (object == NULL) {
+        return;
+    }
+    struct PoolCache* cache = &pool_caches[pool->id];
+
+    // Pełna podręczna lista - oddanie połowy do wspólnej listy
+    if (cache->count == POOL_CACHE_SIZE) {
+        pool_lock(pool);
+        while (cache->count > POOL_CACHE_SIZE / 2) {
+            void* returned = cache->objects[--cache->count];
+            *(void**)returned = pool->free_list;
+            pool->free_list = returned;
+        }
+        pool_unlock(pool);
+    }
+
+    cache->objects[cache->count++] = object;
+    atomic_fetch_add_explicit(&pool->frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&pool->in_use, 1, memory_order_relaxed);
+}
+
+void pool_thread_flush(struct Pool* pool) {
+    struct PoolCache* cache = &pool_caches[pool->id];
+    pool_lock(pool);
+    while (cache->count > 0) {
+        void* returned = cache->objects[--cache->count];
+        *(void**)returned = pool->free_list;
+        pool->free_list = returned;
+    }
+    pool_unlock(pool);
+}
+
+void pool_report(struct Pool* pool) {
+    printf("Pula %s: przydziały %lu, zwolnienia %lu, w użyciu %ld (szczyt %ld), "
+           "płyty %lu (%zu B), uzupełnienia %lu\n",
+           pool->name,
+           atomic_load(&pool->allocs),
+           atomic_load(&pool->frees),
+           atomic_load(&pool->in_use),
+           atomic_load(&pool->peak_in_use),
+           atomic_load(&pool->system_allocs),
+           atomic_load(&pool->system_allocs) * pool->slab_objects * pool->object_size,
+           atomic_load(&pool->refills));
+}
+
+void pool_destroy(struct Pool* pool) {
+    pool_report(pool);
+    long leaked = atomic_load(&pool->in_use);
+    if (leaked != 0) {
+        printf("\033[31mPula %s: niezwrócone obiekty: %ld\033[0m\n", pool->name, leaked);
+    }
+
+    pool_lock(pool);
+    struct PoolSlab* slab = pool->slabs;
+    while (slab != NULL) {
+        struct PoolSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool_unlock(pool);
+
+    // Podręczna lista wskazuje na zwolnione płyty
+    pool_caches[pool->id].count = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Pula obiektów o stałym rozmiarze (alokator płytowy) dla buforów wiadomości.
+// Używana przez serwer i klienta zamiast malloc()/free() na ścieżce pakietów.
+//
+// - pamięć pobierana z malloc() całymi płytami (slab_objects obiektów naraz),
+//   płyty nie są oddawane aż do pool_destroy() - w stanie ustalonym brak wywołań malloc()
+// - każdy wątek ma własną podręczną listę (POOL_CACHE_SIZE obiektów), więc zwykłe
+//   pool_alloc()/pool_free() nie dotykają wspólnej listy ani blokady
+// - liczniki w użyciu/szczyt/płyty pozwalają wykryć wycieki i wzrost zużycia pamięci
+
+#define POOL_MAX_POOLS 8        // Maksymalna liczba pul w procesie (indeks podręcznych list)
+#define POOL_CACHE_SIZE 32      // Pojemność podręcznej listy wątku
+#define POOL_ALIGN 16           // Wyrównanie obiektów
+
+struct PoolSlab;
+
+struct Pool {
+    const char* name;           // Nazwa do komunikatów i statystyk
+    size_t object_size;         // Rozmiar obiektu (wyrównany do POOL_ALIGN)
+    size_t slab_objects;        // Liczba obiektów w jednej płycie
+    int id;                     // Indeks podręcznej listy wątku
+    atomic_flag lock;           // Blokada wspólnej listy wolnych obiektów i listy płyt
+    void* free_list;            // Wspólna lista wolnych obiektów (pod blokadą)
+    struct PoolSlab* slabs;     // Lista płyt (pod blokadą)
+
+    // Statystyki
+    atomic_ulong allocs;        // Liczba pool_alloc()
+    atomic_ulong frees;         // Liczba pool_free()
+    atomic_ulong system_allocs; // Liczba wywołań malloc() (nowe płyty)
+    atomic_ulong refills;       // Uzupełnienia podręcznej listy ze wspólnej
+    atomic_long in_use;         // Obiekty aktualnie wydane
+    atomic_long peak_in_use;    // Najwięcej obiektów wydanych jednocześnie
+};
+
+// Inicjalizuje pulę i od razu przydziela pierwszą płytę. Zwraca 0 albo -1 przy błędzie.
+int pool_init(struct Pool* pool, const char* name, size_t object_size, size_t slab_objects);
+
+// Zwraca obiekt o rozmiarze pool->object_size albo NULL, gdy zabraknie pamięci
+void* pool_alloc(struct Pool* pool);
+
+// Oddaje obiekt do puli. NULL jest ignorowany (jak w free()).
+void pool_free(struct Pool* pool, void* object);
+
+// Oddaje podręczną listę bieżącego wątku do wspólnej listy (przed zakończeniem wątku)
+void pool_thread_flush(struct Pool* pool);
+
+// Wypisuje statystyki puli i liczbę niezwróconych obiektów
+void pool_report(struct Pool* pool);
+
+// Wypisuje statystyki, zgłasza wycieki i zwalnia wszystkie płyty
+void pool_destroy(struct Pool* pool);
+
+#endif
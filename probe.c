@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>     // Biblioteka zawierająca funkcje do obsługi socketów
+#include <arpa/inet.h>      // Biblioteka dla operacji internetowych (inet_pton, htons)
+#include <unistd.h>         // Dla funkcji close()
+#include <time.h>           // Dla clock_gettime()
+#include <sys/select.h>     // Dla select() - oczekiwanie na odpowiedzi między sondami
+
+// Program mierzący opóźnienia i straty serwera: wysyła ponumerowane sondy PING albo REQUEST
+// w stałych odstępach i dopasowuje odpowiedzi (PONG, RESPONSE) po numerze.
+// Na końcu wypisuje liczbę odpowiedzi i percentyle RTT.
+//
+// Porównanie pętli select() i busy-poll (make CFLAGS="-DBUSY_POLL=1"):
+//   ./probe 127.0.0.1 1306 2000 1000       - sonda co 1 ms
+//   ./probe 127.0.0.1 1306 200 500000      - sonda co 500 ms (powrót do select() po bezczynności)
+// Zalew PINGami (odstęp 0) razem z REQUEST pokazuje straty sond aktywności przy przeciążeniu
+// (REQUEST na gniazdo aktywności serwera, port + liveness_port_offset):
+//   ./probe 127.0.0.1 1306 200000 0 & ./probe 127.0.0.1 2306 1000 1000 q
+
+#define BUFFER_SIZE 1024            // Bufor na odpowiedź serwera
+#define DRAIN_TIMEOUT_MS 1000       // Czas oczekiwania na odpowiedzi po wysłaniu wszystkich sond
+#define DRAIN_EVERY 64              // Co ile sond odbierać odpowiedzi w trybie bez przerw
+
+#define PING 'i'
+#define PONG 'o'
+#define REQUEST 'q'
+#define RESPONSE 's'
+
+// Stan pomiaru
+struct ProbeStats {
+    unsigned long long* sent_ns;    // Czas wysłania każdej sondy (0 = nie wysłano)
+    double* rtt_us;                 // RTT odebranych odpowiedzi
+    unsigned long received;         // Odpowiedzi dopasowane do sondy
+    unsigned long unmatched;        // Odpowiedzi powtórzone albo z nieznanym numerem
+    unsigned long send_errors;      // Nieudane sendto()
+};
+
+// Funkcja zwracająca czas monotoniczny w nanosekundach
+unsigned long long monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// Funkcja odbierająca bez blokowania wszystkie czekające odpowiedzi
+// i dopasowująca je do sond po numerze
+void drain_replies(int sock, char reply_type, unsigned long count, struct ProbeStats* stats) {
+    char buffer[BUFFER_SIZE];
+    int recv_len;
+
+    while ((recv_len = recv(sock, buffer, BUFFER_SIZE - 1, MSG_DONTWAIT)) > 0) {
+        unsigned long long now_ns = monotonic_ns();
+        buffer[recv_len] = '\0';
+
+        // PONG: [o][losowa cyfra][treść PINGa], RESPONSE: [s][epoka z REQUEST]
+        int offset = reply_type == PONG ? 2 : 1;
+        char* end;
+        unsigned long seq;
+        if (buffer[0] != reply_type || recv_len <= offset ||
+            (seq = strtoul(buffer + offset, &end, 10)) >= count || *end != '\0' ||
+            stats->sent_ns[seq] == 0) {
+            stats->unmatched++;
+            continue;
+        }
+
+        stats->rtt_us[stats->received++] = (now_ns - stats->sent_ns[seq]) / 1000.0;
+        stats->sent_ns[seq] = 0;    // Powtórzona odpowiedź nie jest liczona drugi raz
+    }
+}
+
+// Funkcja czekająca na odpowiedzi do podanego czasu monotonicznego
+void wait_replies(int sock, unsigned long long until_ns, char reply_type, unsigned long count,
+                  struct ProbeStats* stats) {
+    unsigned long long now_ns;
+    while ((now_ns = monotonic_ns()) < until_ns) {
+        unsigned long long left_us = (until_ns - now_ns) / 1000;
+        struct timeval tv = {left_us / 1000000, left_us % 1000000};
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock, &readfds);
+        if (select(sock + 1, &readfds, NULL, NULL, &tv) > 0) {
+            drain_replies(sock, reply_type, count, stats);
+        }
+    }
+}
+
+int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Funkcja zwracająca percentyl z posortowanej tablicy
+double percentile(const double* sorted, unsigned long count, double p) {
+    unsigned long index = (unsigned long)(p / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 5 && argc != 6) {
+        printf("Użycie: %s <ip_serwera> <port_serwera> <liczba_sond> <odstęp_us> [typ]\n", argv[0]);
+        printf("  odstęp_us: 0 - bez przerw (zalew)\n");
+        printf("  typ: i - PING (domyślnie), q - REQUEST\n");
+        printf("Przykład: %s 127.0.0.1 1306 2000 1000\n", argv[0]);
+        return 1;
+    }
+
+    unsigned long count = strtoul(argv[3], NULL, 10);
+    unsigned long long gap_ns = strtoull(argv[4], NULL, 10) * 1000ull;
+    char probe_type = argc == 6 ? argv[5][0] : PING;
+    if (count == 0 || (probe_type != PING && probe_type != REQUEST)) {
+        printf("Nieprawidłowa liczba sond albo typ\n");
+        return 1;
+    }
+    char reply_type = probe_type == PING ? PONG : RESPONSE;
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(atoi(argv[2]));
+    if (inet_pton(AF_INET, argv[1], &server_addr.sin_addr) <= 0) {
+        printf("Nieprawidłowy adres IP serwera\n");
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("Błąd socket");
+        return 1;
+    }
+
+    struct ProbeStats stats = {0};
+    stats.sent_ns = calloc(count, sizeof(*stats.sent_ns));
+    stats.rtt_us = malloc(count * sizeof(*stats.rtt_us));
+    if (stats.sent_ns == NULL || stats.rtt_us == NULL) {
+        printf("Brak pamięci na %lu sond\n", count);
+        return 1;
+    }
+
+    printf("Sondy %s do %s:%s: %lu, odstęp %s us\n",
+           probe_type == PING ? "PING" : "REQUEST", argv[1], argv[2], count, argv[4]);
+
+    unsigned long long start_ns = monotonic_ns();
+    for (unsigned long seq = 0; seq < count; seq++) {
+        if (gap_ns > 0) {
+            wait_replies(sock, start_ns + seq * gap_ns, reply_type, count, &stats);
+        } else if (seq % DRAIN_EVERY == 0) {
+            drain_replies(sock, reply_type, count, &stats);
+        }
+
+        // Numer sondy jako treść: PING o długości jak u klienta, REQUEST jako epoka
+        char message[32];
+        int length = probe_type == PING ? sprintf(message, "%c%012lu", PING, seq)
+                                        : sprintf(message, "%c%lu", REQUEST, seq);
+        stats.sent_ns[seq] = monotonic_ns();
+        if (sendto(sock, message, length, 0, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            stats.sent_ns[seq] = 0;
+            stats.send_errors++;
+        }
+    }
+    double elapsed = (monotonic_ns() - start_ns) / 1e9;
+
+    // Oczekiwanie na ostatnie odpowiedzi
+    wait_replies(sock, monotonic_ns() + DRAIN_TIMEOUT_MS * 1000000ull, reply_type, count, &stats);
+
+    printf("Wysłano %lu sond (błędy: %lu) w %.3f s\n", count - stats.send_errors, stats.send_errors, elapsed);
+    printf("Odpowiedzi: %lu/%lu (%.1f%%), niedopasowane: %lu\n",
+           stats.received, count, 100.0 * stats.received / count, stats.unmatched);
+    if (stats.received > 0) {
+        qsort(stats.rtt_us, stats.received, sizeof(double), compare_double);
+        printf("RTT: p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n",
+               percentile(stats.rtt_us, stats.received, 50),
+               percentile(stats.rtt_us, stats.received, 90),
+               percentile(stats.rtt_us, stats.received, 99),
+               stats.rtt_us[stats.received - 1]);
+    }
+
+    free(stats.sent_ns);
+    free(stats.rtt_us);
+    close(sock);
+    return 0;
+}
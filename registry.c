@@ -0,0 +1,115 @@
+#include "registry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Wpisy używane, dopóki klient nie zmapuje migawki rejestru (i w programach testowych)
+static struct ServerInfo servers_fallback[MAX_SERVERS];
+
+// Globalna tablica serwerów - wskazuje na wpisy rejestru, więc każda zmiana
+// pola od razu trafia do zmapowanego pliku (bez przepisywania całej migawki)
+struct ServerInfo* servers = servers_fallback;
+atomic_int server_count = 0;
+
+struct ProbeRound probe_round = {.epoch = 0, .pending_probes = 0};
+
+// Funkcja licząca nieudaną próbę (wysłany REQUEST bez odpowiedzi w poprzednich rundach).
+// Zwiększenie licznika i przejście UP -> DOWN po max_attempts próbach to jedna zamiana
+// compare-and-swap słowa liveness: odpowiedź zapisana w międzyczasie (mark_server_alive)
+// zmienia słowo, więc CAS się nie udaje, a ponowienie widzi wyzerowany licznik.
+// Odpowiedź zapisana po udanym CAS nadpisuje DOWN z powrotem na UP.
+// attempts - numer tej próby. Zwraca 1, gdy serwer został oznaczony jako DOWN
+int record_failed_request(int index, int max_attempts, int* attempts) {
+    unsigned int state = atomic_load(&servers[index].liveness);
+    unsigned int next;
+    do {
+        if (LIVENESS_STATUS(state) != UP) {
+            *attempts = 0;
+            return 0;
+        }
+        *attempts = LIVENESS_FAILED(state) + 1;
+        next = *attempts >= max_attempts ? LIVENESS(DOWN, 0) : LIVENESS(UP, *attempts);
+    } while (!atomic_compare_exchange_weak(&servers[index].liveness, &state, next));
+
+    return LIVENESS_STATUS(next) == DOWN;
+}
+
+// Funkcja rozpoczynająca zapis wpisu rejestru (seqlock).
+// Ustawia nieparzysty licznik - czytelnicy, którzy trafią na zapis, ponawiają odczyt.
+// Zapisujący wykluczają się nawzajem: czekają aż licznik będzie parzysty (zapisy są krótkie)
+void registry_write_begin(int index) {
+    unsigned int seq = atomic_load_explicit(&servers[index].seq, memory_order_relaxed);
+    while ((seq & 1) ||
+           !atomic_compare_exchange_weak_explicit(&servers[index].seq, &seq, seq + 1,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+        seq = atomic_load_explicit(&servers[index].seq, memory_order_relaxed);
+    }
+    // Zapisy pól nie mogą zostać przeniesione przed ustawienie nieparzystego licznika
+    atomic_thread_fence(memory_order_release);
+}
+
+// Funkcja kończąca zapis wpisu rejestru - licznik znowu parzysty
+void registry_write_end(int index) {
+    atomic_fetch_add_explicit(&servers[index].seq, 1, memory_order_release);
+}
+
+// Funkcja kopiująca spójny stan wpisu rejestru bez blokowania zapisującego.
+// Odczyt jest powtarzany, gdy w trakcie kopiowania trwał zapis (licznik się zmienił)
+void registry_read(int index, struct ServerInfo* copy) {
+    unsigned int before, after;
+    do {
+        before = atomic_load_explicit(&servers[index].seq, memory_order_acquire);
+        memcpy(copy, &servers[index], sizeof(*copy));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&servers[index].seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+// Funkcja wyszukująca serwer po adresie nadawcy - porcie danych albo porcie aktywności (RESPONSE)
+// Wywoływana w wątku odbiorczym, który jako jedyny zmienia ip i porty, więc czyta wprost
+// Zwraca indeks w tablicy servers albo -1
+int find_server(const char* ip, int port) {
+    int count = atomic_load(&server_count);
+    for(int i = 0; i < count; i++) {
+        if(strcmp(servers[i].ip, ip) == 0 &&
+           (servers[i].port == port || servers[i].liveness_port == port)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Funkcja zapisująca, że od serwera przyszedł pakiet - każdy pakiet
+// (HELLO, PONG, RESPONSE) potwierdza aktywność tak samo jak RESPONSE
+// recv_time - czas pakietu zwalniającego z następnej rundy REQUEST; NULL dla samego
+// RESPONSE, aby odpowiedź na sondę nie wydłużała odstępu między sondami
+void mark_server_alive(int index, struct timeval* recv_time) {
+    atomic_store(&servers[index].liveness, LIVENESS(UP, 0));
+    if(recv_time != NULL) {
+        registry_write_begin(index);
+        servers[index].last_seen = recv_time->tv_sec;
+        servers[index].last_seen_usec = recv_time->tv_usec;
+        registry_write_end(index);
+    }
+    atomic_fetch_and(&probe_round.pending_probes, ~(1u << index));
+}
+
+// Funkcja wybierająca losowy aktywny serwer
+// Status każdego serwera jest czytany raz, więc zmiana w trakcie wyboru
+// (przez wątek odbiorczy) nie może dać pustego wyniku mimo aktywnych serwerów
+int get_random_active_server() {
+    int count = atomic_load(&server_count);
+    if (count == 0) return -1;
+
+    int active[MAX_SERVERS];
+    int active_servers = 0;
+    for(int i = 0; i < count; i++) {
+        if(LIVENESS_STATUS(atomic_load(&servers[i].liveness)) == UP) {
+            active[active_servers++] = i;
+        }
+    }
+
+    if (active_servers == 0) return -1;
+
+    return active[rand() % active_servers];
+}
@@ -0,0 +1,84 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/time.h>       // Dla struct timeval
+
+// Rejestr serwerów klienta - tablica wpisów czytana i zmieniana przez kilka wątków bez blokad.
+// Zwykłe pola wpisu chroni seqlock (registry_write_begin/registry_write_end, registry_read),
+// a status aktywności z licznikiem prób jest osobnym słowem atomowym (LIVENESS).
+// Klient przestawia servers na wpisy zmapowanej migawki, więc zmiany trafiają od razu do pliku.
+
+#define MAX_SERVERS 10      // Maksymalna liczba serwerów w tablicy
+#define MAX_IP_LENGTH 16    // Maksymalna długość adresu IP (format XXX.XXX.XXX.XXX\0)
+#define UP 1               // Status serwera - aktywny
+#define DOWN 0             // Status serwera - nieaktywny
+
+// Stan aktywności serwera w jednym słowie atomowym: bit 0 - status (UP/DOWN),
+// wyższe bity - licznik nieudanych prób. Odpowiedź zapisuje całe słowo naraz,
+// a harmonogram sond zmienia je przez compare-and-swap, więc decyzja o DOWN
+// i zerowanie licznika nie mogą rozminąć się z odpowiedzią przychodzącą w tym samym czasie
+#define LIVENESS(status, failed) (((unsigned int)(failed) << 1) | (unsigned int)(status))
+#define LIVENESS_STATUS(word) ((int)((word) & 1u))
+#define LIVENESS_FAILED(word) ((int)((word) >> 1))
+
+// Struktura przechowująca informacje o serwerze
+// Używa typów wbudowanych w C do śledzenia stanu serwera.
+//
+// Rejestr jest bezpieczny przy wielu wątkach (patrz registry_write_begin/registry_read):
+// - pola zwykłe zmieniają się tylko między registry_write_begin() i registry_write_end()
+// - liveness (status i licznik prób) jest jednym słowem atomowym, bo zmieniają je
+//   i wątek odbiorczy (odpowiedzi), i harmonogram sond (przejście w DOWN)
+// - czytelnicy biorą spójną kopię przez registry_read() i nigdy nie czekają na zapis
+struct ServerInfo {
+    atomic_uint seq;            // Licznik seqlock - nieparzysty w trakcie zapisu
+    int id;                     // Identyfikator serwera
+    char ip[MAX_IP_LENGTH];     // Tablica znaków na adres IP (statyczna alokacja)
+    int port;                   // Numer portu
+    int liveness_port;          // Port gniazda sond aktywności (REQUEST) - z HELLO, domyślnie port
+    atomic_uint liveness;       // Status (UP/DOWN) i licznik nieudanych prób - LIVENESS()
+    time_t last_seen;           // Znacznik czasu ostatniego pakietu od serwera (sekundy)
+    long last_seen_usec;        // Mikrosekundy ostatniego pakietu od serwera
+    double srtt_ms;             // Wygładzony RTT PING-PONG (0 = brak pomiaru)
+};
+
+// Stan rundy sprawdzania aktywności. Wszystkie serwery sprawdzane w jednej rundzie
+// dostają REQUEST z tą samą epoką, a bity pending_probes oznaczają serwery,
+// które jeszcze nie odpowiedziały w bieżącej epoce (MAX_SERVERS musi mieścić się w masce)
+struct ProbeRound {
+    atomic_uint epoch;           // Numer bieżącej rundy (wysyłany w REQUEST i odsyłany w RESPONSE)
+    atomic_uint pending_probes;  // Maska bitowa indeksów serwerów czekających na RESPONSE
+    struct timeval start_time;   // Początek bieżącej rundy
+};
+extern struct ProbeRound probe_round;
+_Static_assert(MAX_SERVERS <= 32, "pending_probes to maska 32-bitowa - MAX_SERVERS nie może przekroczyć 32");
+
+// Tablica serwerów - domyślnie statyczna, klient przestawia ją na wpisy zmapowanej migawki
+extern struct ServerInfo* servers;
+// Licznik aktywnych serwerów - zwiększany (publikowany) dopiero po wypełnieniu wpisu,
+// więc czytelnik widzi tylko kompletne wpisy
+extern atomic_int server_count;
+
+// Rozpoczyna zapis wpisu (licznik seqlock nieparzysty), czeka na innego zapisującego
+void registry_write_begin(int index);
+
+// Kończy zapis wpisu (licznik znowu parzysty)
+void registry_write_end(int index);
+
+// Kopiuje spójny stan wpisu, ponawiając odczyt przerwany zapisem
+void registry_read(int index, struct ServerInfo* copy);
+
+// Zwraca indeks serwera o podanym adresie (port danych albo port aktywności) albo -1
+int find_server(const char* ip, int port);
+
+// Oznacza serwer jako aktywny po odebraniu od niego pakietu
+void mark_server_alive(int index, struct timeval* recv_time);
+
+// Liczy nieudaną próbę sprawdzenia aktywności. Zwraca 1, gdy serwer przeszedł w DOWN
+int record_failed_request(int index, int max_attempts, int* attempts);
+
+// Zwraca indeks losowego aktywnego serwera albo -1
+int get_random_active_server();
+
+#endif
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>         // Dla sleep()
+
+#include "registry.h"
+
+// Test obciążeniowy rejestru serwerów (registry.c): kilka wątków zapisuje wpisy
+// przez registry_write_begin/registry_write_end i mark_server_alive, harmonogram sond
+// liczy nieudane próby (record_failed_request), a czytelnicy sprawdzają, czy żadna kopia
+// z registry_read nie jest rozerwana i czy get_random_active_server zawsze coś wybiera.
+//
+// Każdy zapis ustawia wszystkie pola wpisu na wartości wyliczone z jednej liczby,
+// więc kopia z polami z dwóch różnych zapisów oznacza błąd seqlocka.
+// Serwer 0 nigdy nie dostaje sondy, więc zawsze jest aktywny.
+//
+//   make stress                 - 3 sekundy
+//   ./registry_stress 30        - dłuższy przebieg
+
+#define DEFAULT_DURATION 3          // Czas testu w sekundach
+#define WRITERS 2                   // Wątki zapisujące (wykluczają się na liczniku seqlock)
+#define READERS 2                   // Wątki czytające
+#define MAX_ATTEMPTS 3              // Próby przed przejściem w DOWN (jak MAX_REQUEST_ATTEMPTS)
+
+static atomic_int stop = 0;
+static atomic_ulong failures = 0;
+
+// Liczniki jednego wątku
+struct ThreadStats {
+    int id;
+    unsigned long operations;
+};
+
+// Wypełnia wpis wartościami wyliczonymi z value
+static void fill_entry(struct ServerInfo* entry, unsigned int value) {
+    entry->id = (int)value;
+    entry->port = (int)value;
+    entry->liveness_port = (int)value;
+    memset(entry->ip, 'a' + value % 26, MAX_IP_LENGTH - 1);
+    entry->ip[MAX_IP_LENGTH - 1] = '\0';
+    entry->srtt_ms = value;
+}
+
+// Zwraca 1, gdy kopia pochodzi z jednego zapisu
+static int entry_consistent(const struct ServerInfo* copy) {
+    unsigned int value = (unsigned int)copy->id;
+    if (copy->port != (int)value || copy->liveness_port != (int)value ||
+        copy->srtt_ms != (double)value || copy->ip[MAX_IP_LENGTH - 1] != '\0') {
+        return 0;
+    }
+    for (int i = 0; i < MAX_IP_LENGTH - 1; i++) {
+        if (copy->ip[i] != (char)('a' + value % 26)) {
+            return 0;
+        }
+    }
+    // last_seen zmienia mark_server_alive osobnym zapisem - para też musi być spójna
+    return copy->last_seen == copy->last_seen_usec;
+}
+
+static void report_failure(const char* what, int index) {
+    if (atomic_fetch_add(&failures, 1) < 10) {
+        printf("\033[31mBłąd: %s (serwer %d)\033[0m\n", what, index);
+    }
+}
+
+static void* writer_thread(void* arg) {
+    struct ThreadStats* stats = arg;
+    unsigned int value = stats->id;
+    while (!atomic_load(&stop)) {
+        for (int i = 0; i < MAX_SERVERS; i++) {
+            value += WRITERS;
+            registry_write_begin(i);
+            fill_entry(&servers[i], value);
+            registry_write_end(i);
+
+            struct timeval seen = {value, value};
+            mark_server_alive(i, &seen);
+            stats->operations += 2;
+        }
+    }
+    return NULL;
+}
+
+static void* prober_thread(void* arg) {
+    struct ThreadStats* stats = arg;
+    while (!atomic_load(&stop)) {
+        for (int i = 1; i < MAX_SERVERS; i++) {
+            int attempts;
+            record_failed_request(i, MAX_ATTEMPTS, &attempts);
+            if (attempts > MAX_ATTEMPTS) {
+                report_failure("licznik prób przekroczył limit", i);
+            }
+            stats->operations++;
+        }
+    }
+    return NULL;
+}
+
+static void* reader_thread(void* arg) {
+    struct ThreadStats* stats = arg;
+    struct ServerInfo copy;
+    while (!atomic_load(&stop)) {
+        for (int i = 0; i < MAX_SERVERS; i++) {
+            registry_read(i, &copy);
+            if (!entry_consistent(&copy)) {
+                report_failure("rozerwana kopia wpisu", i);
+            }
+            unsigned int liveness = atomic_load(&servers[i].liveness);
+            if (LIVENESS_FAILED(liveness) >= MAX_ATTEMPTS) {
+                report_failure("licznik prób bez przejścia w DOWN", i);
+            }
+            if (i == 0 && LIVENESS_STATUS(liveness) != UP) {
+                report_failure("serwer bez sond oznaczony jako DOWN", i);
+            }
+
+            int chosen = get_random_active_server();
+            if (chosen < 0 || chosen >= MAX_SERVERS) {
+                report_failure("get_random_active_server bez wyniku", chosen);
+            }
+            stats->operations += 2;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    int duration = argc > 1 ? atoi(argv[1]) : DEFAULT_DURATION;
+    if (duration <= 0) {
+        printf("Użycie: %s [czas_s]\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        fill_entry(&servers[i], 0);
+        atomic_store(&servers[i].liveness, LIVENESS(UP, 0));
+    }
+    atomic_store(&server_count, MAX_SERVERS);
+
+    pthread_t threads[WRITERS + 1 + READERS];
+    struct ThreadStats stats[WRITERS + 1 + READERS];
+    const char* names[WRITERS + 1 + READERS];
+    int thread_count = 0;
+
+    for (int i = 0; i < WRITERS + 1 + READERS; i++) {
+        void* (*function)(void*) = i < WRITERS ? writer_thread
+                                 : i == WRITERS ? prober_thread : reader_thread;
+        names[i] = i < WRITERS ? "zapis" : i == WRITERS ? "sondy" : "odczyt";
+        stats[i].id = i;
+        stats[i].operations = 0;
+        if (pthread_create(&threads[i], NULL, function, &stats[i]) != 0) {
+            perror("Błąd pthread_create");
+            atomic_store(&stop, 1);
+            break;
+        }
+        thread_count++;
+    }
+
+    printf("Test rejestru: %d serwerów, %d wątki zapisujące, %d czytające, %d s\n",
+           MAX_SERVERS, WRITERS, READERS, duration);
+    if (thread_count == WRITERS + 1 + READERS) {
+        sleep(duration);
+    }
+    atomic_store(&stop, 1);
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+        printf("  wątek %d (%s): %lu operacji\n", i, names[i], stats[i].operations);
+    }
+
+    unsigned long failed = atomic_load(&failures);
+    if (failed > 0 || thread_count != WRITERS + 1 + READERS) {
+        printf("\033[31mTest rejestru: %lu błędów\033[0m\n", failed);
+        return 1;
+    }
+    printf("\033[32mTest rejestru: brak rozerwanych kopii\033[0m\n");
+    return 0;
+}
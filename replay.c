@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>     // Biblioteka zawierająca funkcje do obsługi socketów
+#include <arpa/inet.h>      // Biblioteka dla operacji internetowych (inet_pton, htons)
+#include <unistd.h>         // Dla funkcji close()
+#include <time.h>           // Dla clock_gettime() i clock_nanosleep()
+#include <fcntl.h>          // Dla open()
+#include <sys/mman.h>       // Dla mmap() - odczyt pliku zapisu
+#include <sys/stat.h>       // Dla fstat() - rozmiar pliku zapisu
+#include <sys/select.h>     // Dla select() - oczekiwanie na ostatnie odpowiedzi
+#include <netinet/udp.h>    // Dla UDP_SEGMENT - wysyłanie wielu datagramów jednym wywołaniem
+#include <errno.h>
+
+#include "capture.h"
+
+// Program odtwarzający zapis ruchu utworzony przez serwer lub klienta.
+// Wysyła do wskazanego serwera te datagramy, które w oryginale do serwera trafiły:
+// z zapisu serwera - odebrane (CAPTURE_IN), z zapisu klienta - wysłane (CAPTURE_OUT).
+// Odpowiedzi serwera są tylko liczone.
+//
+// W trybie bez przerw kolejne datagramy tej samej długości są wysyłane jednym sendmsg()
+// z UDP_SEGMENT (GSO) - jądro samo dzieli bufor na datagramy.
+
+#define BUFFER_SIZE 65536           // Bufor na odpowiedzi serwera
+#define DRAIN_TIMEOUT_MS 1000       // Czas oczekiwania na odpowiedzi po wysłaniu całości
+#define DRAIN_EVERY 64              // Co ile wywołań wysyłania odbierać odpowiedzi w trybie bez przerw
+#define GSO_MAX_SEGMENTS 64         // Limit jądra na liczbę segmentów w jednym wywołaniu
+#define GSO_BUFFER_SIZE 65000       // Maksymalny rozmiar bufora GSO (limit datagramu UDP z zapasem)
+
+// Statystyki odtwarzania
+struct ReplayStats {
+    unsigned long sent;             // Wysłane datagramy
+    unsigned long sent_bytes;       // Wysłane bajty
+    unsigned long send_errors;      // Nieudane sendto()
+    unsigned long send_calls;       // Wywołania systemowe wysyłania
+    unsigned long received;         // Odebrane odpowiedzi
+};
+
+// Funkcja zwracająca czas monotoniczny w nanosekundach
+unsigned long long monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// Datagramy równej długości czekające na wspólne wysłanie z UDP_SEGMENT
+struct GsoBatch {
+    char data[GSO_BUFFER_SIZE];
+    int segment_size;               // Długość każdego datagramu w buforze
+    int count;                      // Liczba datagramów w buforze
+};
+
+// Czy jądro obsługuje UDP_SEGMENT (sprawdzane przy starcie, wyłączane po błędzie wysyłania)
+static int gso_enabled = 0;
+
+// Funkcja sprawdzająca obsługę UDP GSO - starsze jądra (< 4.18) zwracają ENOPROTOOPT
+int gso_supported(int sock) {
+    int segment_size = 0;
+    socklen_t size_len = sizeof(segment_size);
+    return getsockopt(sock, SOL_UDP, UDP_SEGMENT, &segment_size, &size_len) == 0;
+}
+
+// Funkcja wysyłająca pojedynczy datagram
+void send_single(int sock, const char* data, size_t length, struct sockaddr_in* addr,
+                 struct ReplayStats* stats) {
+    stats->send_calls++;
+    if (sendto(sock, data, length, 0, (struct sockaddr*)addr, sizeof(*addr)) < 0) {
+        stats->send_errors++;
+    } else {
+        stats->sent++;
+        stats->sent_bytes += length;
+    }
+}
+
+// Funkcja wysyłająca zebrane datagramy jednym sendmsg() z UDP_SEGMENT
+// Gdy jądro lub interfejs odrzuci GSO, wysyła pojedynczo i wyłącza GSO
+void gso_flush(int sock, struct GsoBatch* batch, struct sockaddr_in* addr, struct ReplayStats* stats) {
+    if (batch->count == 0) {
+        return;
+    }
+    if (batch->count == 1) {
+        send_single(sock, batch->data, batch->segment_size, addr, stats);
+        batch->count = 0;
+        return;
+    }
+
+    size_t total = (size_t)batch->segment_size * batch->count;
+    struct iovec iov = { .iov_base = batch->data, .iov_len = total };
+    char control[CMSG_SPACE(sizeof(uint16_t))];
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memset(control, 0, sizeof(control));
+    hdr.msg_name = addr;
+    hdr.msg_namelen = sizeof(*addr);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t segment_size = batch->segment_size;
+    memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+    stats->send_calls++;
+    if (sendmsg(sock, &hdr, 0) < 0) {
+        if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT) {
+            perror("Ostrzeżenie: UDP GSO odrzucone, wysyłanie pojedynczo");
+            gso_enabled = 0;
+            for (int i = 0; i < batch->count; i++) {
+                send_single(sock, batch->data + i * batch->segment_size, batch->segment_size, addr, stats);
+            }
+        } else {
+            stats->send_errors += batch->count;
+        }
+    } else {
+        stats->sent += batch->count;
+        stats->sent_bytes += total;
+    }
+    batch->count = 0;
+}
+
+// Funkcja dodająca datagram do bufora GSO - bufor jest wysyłany, gdy datagram
+// ma inną długość, bufor jest pełny albo osiągnięto limit segmentów
+void gso_queue(int sock, struct GsoBatch* batch, const char* data, size_t length,
+               struct sockaddr_in* addr, struct ReplayStats* stats) {
+    if (batch->count > 0 &&
+        ((int)length != batch->segment_size ||
+         batch->count >= GSO_MAX_SEGMENTS ||
+         (size_t)batch->segment_size * (batch->count + 1) > GSO_BUFFER_SIZE)) {
+        gso_flush(sock, batch, addr, stats);
+    }
+    if (length == 0 || length > GSO_BUFFER_SIZE) {
+        send_single(sock, data, length, addr, stats);
+        return;
+    }
+
+    batch->segment_size = length;
+    memcpy(batch->data + (size_t)batch->count * length, data, length);
+    batch->count++;
+}
+
+// Funkcja odbierająca bez blokowania wszystkie czekające odpowiedzi
+void drain_responses(int sock, struct ReplayStats* stats) {
+    static char buffer[BUFFER_SIZE];
+    while (recv(sock, buffer, BUFFER_SIZE, MSG_DONTWAIT) > 0) {
+        stats->received++;
+    }
+}
+
+// Funkcja usypiająca do podanego czasu monotonicznego (w nanosekundach)
+void sleep_until(unsigned long long target_ns) {
+    struct timespec target;
+    target.tv_sec = target_ns / 1000000000ull;
+    target.tv_nsec = target_ns % 1000000000ull;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL) != 0) {
+        // Przerwane przez sygnał - ponowienie
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4 || argc > 6) {
+        printf("Użycie: %s <plik_zapisu> <ip_serwera> <port_serwera> [przyspieszenie] [gso]\n", argv[0]);
+        printf("  przyspieszenie: 1 - oryginalne tempo (domyślnie), 10 - 10x szybciej, 0 - bez przerw\n");
+        printf("  gso: 1 - UDP GSO w trybie bez przerw, jeśli dostępne (domyślnie), 0 - wyłączone\n");
+        printf("Przykład: %s server.cap 127.0.0.1 1306 0\n", argv[0]);
+        return 1;
+    }
+
+    double speed = argc >= 5 ? atof(argv[4]) : 1.0;
+    int use_gso = argc == 6 ? atoi(argv[5]) : 1;
+    if (speed < 0) {
+        printf("Przyspieszenie nie może być ujemne\n");
+        return 1;
+    }
+
+    // Zmapowanie pliku zapisu tylko do odczytu
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        perror("Błąd otwarcia pliku zapisu");
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct CaptureHeader)) {
+        printf("Plik zapisu jest za krótki\n");
+        close(fd);
+        return 1;
+    }
+    char* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Błąd mmap pliku zapisu");
+        return 1;
+    }
+
+    struct CaptureHeader* header = (struct CaptureHeader*)map;
+    if (header->magic != CAPTURE_MAGIC || header->version != CAPTURE_VERSION) {
+        printf("Nieprawidłowy format pliku zapisu\n");
+        return 1;
+    }
+    // Zapis przerwany przed capture_close() ma plik dłuższy niż used - liczy się used
+    size_t used = header->used;
+    if (used > (size_t)st.st_size) {
+        used = st.st_size;
+    }
+    uint8_t replay_direction = header->role == CAPTURE_ROLE_SERVER ? CAPTURE_IN : CAPTURE_OUT;
+
+    // Adres serwera docelowego
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(atoi(argv[3]));
+    if (inet_pton(AF_INET, argv[2], &server_addr.sin_addr) <= 0) {
+        printf("Nieprawidłowy adres IP serwera\n");
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("Błąd socket");
+        return 1;
+    }
+
+    // GSO łączy datagramy wysyłane jeden za drugim, więc ma sens tylko bez przerw
+    gso_enabled = use_gso && speed == 0 && gso_supported(sock);
+
+    printf("Odtwarzanie %s (zapis %s) do %s:%s, przyspieszenie %.2fx%s, UDP GSO: %s\n",
+           argv[1],
+           header->role == CAPTURE_ROLE_SERVER ? "serwera" : "klienta",
+           argv[2], argv[3],
+           speed,
+           speed > 0 ? "" : " (bez przerw)",
+           gso_enabled ? "tak" : "nie");
+
+    static struct GsoBatch gso_batch;
+    struct ReplayStats stats = {0, 0, 0, 0, 0};
+    unsigned long long first_record_ns = 0;
+    unsigned long long start_ns = monotonic_ns();
+    size_t offset = sizeof(struct CaptureHeader);
+
+    while (offset + sizeof(struct CaptureRecord) <= used) {
+        struct CaptureRecord* record = (struct CaptureRecord*)(map + offset);
+        size_t record_size = CAPTURE_RECORD_SIZE(record->length);
+        if (offset + record_size > used) {
+            printf("Uszkodzony rekord na pozycji %zu - koniec odtwarzania\n", offset);
+            break;
+        }
+        offset += record_size;
+
+        if (record->direction != replay_direction) {
+            continue;
+        }
+
+        // Zachowanie odstępów czasowych z zapisu (podzielonych przez przyspieszenie)
+        if (first_record_ns == 0) {
+            first_record_ns = record->timestamp_ns;
+        }
+        if (speed > 0) {
+            unsigned long long delay_ns = (record->timestamp_ns - first_record_ns) / speed;
+            drain_responses(sock, &stats);
+            sleep_until(start_ns + delay_ns);
+        }
+
+        unsigned long calls_before = stats.send_calls;
+        if (gso_enabled) {
+            gso_queue(sock, &gso_batch, (char*)(record + 1), record->length, &server_addr, &stats);
+        } else {
+            send_single(sock, (char*)(record + 1), record->length, &server_addr, &stats);
+        }
+
+        // Bez przerw odpowiedzi nie są odbierane przy usypianiu - odbiór co DRAIN_EVERY
+        // wywołań, aby nie przepełnić bufora odbiorczego
+        if (speed == 0 && stats.send_calls != calls_before && stats.send_calls % DRAIN_EVERY == 0) {
+            drain_responses(sock, &stats);
+        }
+    }
+    gso_flush(sock, &gso_batch, &server_addr, &stats);
+
+    double elapsed = (monotonic_ns() - start_ns) / 1e9;
+
+    // Oczekiwanie na ostatnie odpowiedzi
+    unsigned long long drain_end_ns = monotonic_ns() + DRAIN_TIMEOUT_MS * 1000000ull;
+    while (monotonic_ns() < drain_end_ns) {
+        fd_set readfds;
+        struct timeval tv = {0, 100000};  // 100ms timeout
+        FD_ZERO(&readfds);
+        FD_SET(sock, &readfds);
+        if (select(sock + 1, &readfds, NULL, NULL, &tv) > 0) {
+            drain_responses(sock, &stats);
+        }
+    }
+
+    printf("Wysłano %lu datagramów (%lu B, błędy: %lu) w %.3f s - %.0f pakietów/s, %lu wywołań wysyłania\n",
+           stats.sent, stats.sent_bytes, stats.send_errors, elapsed,
+           elapsed > 0 ? stats.sent / elapsed : 0.0, stats.send_calls);
+    printf("Odebrano %lu odpowiedzi\n", stats.received);
+
+    munmap(map, st.st_size);
+    close(sock);
+    return 0;
+}
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE         // Dla recvmmsg() i sched_setaffinity()
 #include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,11 +7,81 @@
 #include <arpa/inet.h>      // Biblioteka dla operacji internetowych (inet_pton, htons)
 #include <unistd.h>         // Dla funkcji close()
 #include <time.h>           // Dla funkcji time() używanej w generowaniu liczb losowych
+#include <errno.h>          // Dla errno (EAGAIN przy gnieździe nieblokującym)
+#include <sched.h>          // Dla sched_setaffinity() - przypinanie procesu do rdzenia
+#include <sys/mman.h>       // Dla mlockall() - blokowanie pamięci w RAM
+#include <stdint.h>         // Dla uint32_t (licznik SO_RXQ_OVFL)
+#include <netinet/udp.h>    // Dla UDP_GRO - łączenie datagramów przy odbiorze
+#include <stddef.h>         // Dla offsetof() - opis kluczy konfiguracji
+
+#include "capture.h"        // Zapis ruchu do pliku (tryb przechwytywania)
+#include "pool.h"           // Pula buforów wiadomości zamiast malloc()/free()
+#include "parse.h"          // Wektorowa walidacja i klasyfikacja odebranych wiadomości
+#include "config.h"         // Plik konfiguracyjny i przeładowanie po SIGHUP
+#include "udp.h"            // Bufory gniazda, licznik SO_RXQ_OVFL, send_datagram()
+#include "frame.h"          // Ramki zbiorcze - kilka wiadomości w jednym datagramie
+#include "signals.h"        // Zakończenie przez SIGINT/SIGTERM z zamknięciem zapisu ruchu
 
 #define SERVER_PORT 1307    // Port nasłuchiwania serwera
 #define CLIENT_PORT 1305    // Port na który jest wysyłane do klienta
 #define BUFFER_SIZE 1024    // Rozmiar bufora na wiadomości
 #define CLIENT_IP "127.0.0.1"
+#define HELLO_INTERVAL 5    // Okres wysyłania wiadomości HELLO (sekundy)
+#define SERVER_CONFIG_PATH "server.conf"  // Plik konfiguracyjny (katalog roboczy)
+#define PACKET_POOL_SLAB 64 // Liczba buforów wiadomości w jednej płycie puli
+
+// Tryb niskich opóźnień (busy-poll) - domyślnie wyłączony, włączany przy kompilacji:
+// make CFLAGS="-DBUSY_POLL=1 -DBUSY_POLL_CPU=2"
+#ifndef BUSY_POLL
+#define BUSY_POLL 0               // 1 = aktywne odpytywanie gniazda zamiast select()
+#endif
+#ifndef BUSY_POLL_CPU
+#define BUSY_POLL_CPU 0           // Rdzeń CPU, do którego przypinany jest serwer
+#endif
+#ifndef BUSY_POLL_USEC
+#define BUSY_POLL_USEC 50         // Wartość SO_BUSY_POLL - czas odpytywania sterownika (us)
+#endif
+#ifndef BUSY_POLL_IDLE_MS
+#define BUSY_POLL_IDLE_MS 200     // Budżet bezczynności, po którym serwer wraca do select()
+#endif
+#define RECV_BATCH 16             // Pojemność partii recvmmsg() (klucz recv_batch może ją zmniejszyć)
+
+// UDP GRO - jądro łączy kolejne datagramy tego samego rozmiaru od jednego nadawcy
+// w jeden bufor (do 64 segmentów), a rozmiar segmentu podaje w komunikacie kontrolnym.
+// Włączane gdy jądro je obsługuje (sprawdzane przy starcie), wyłączane przez -DUSE_UDP_GRO=0
+#ifndef USE_UDP_GRO
+#define USE_UDP_GRO 1
+#endif
+#define GRO_BUFFER_SIZE 65536             // Bufor na połączone datagramy (maks. rozmiar UDP)
+#define GRO_MAX_SEGMENTS 64               // Maksymalna liczba segmentów w jednym buforze GRO
+#define MAX_SEGMENTS (RECV_BATCH * GRO_MAX_SEGMENTS)
+
+// Bufory gniazda - 0 oznacza domyślną wartość jądra (net.core.rmem_default/wmem_default)
+#ifndef SOCKET_RCVBUF
+#define SOCKET_RCVBUF 0
+#endif
+#ifndef SOCKET_SNDBUF
+#define SOCKET_SNDBUF 0
+#endif
+
+// Kontrola przyjęć przy przeciążeniu: gdy w kolejce czeka co najmniej
+// ADMISSION_OVERLOAD_BATCH datagramów albo jądro zgubiło pakiety, serwer najpierw
+// odpowiada na REQUEST (wykrywanie awarii), a PINGów obsługuje najwyżej ADMISSION_PING_BUDGET
+#ifndef ADMISSION_OVERLOAD_BATCH
+#define ADMISSION_OVERLOAD_BATCH 8
+#endif
+#ifndef ADMISSION_PING_BUDGET
+#define ADMISSION_PING_BUDGET 2
+#endif
+#define PREFAULT_STACK_SIZE (64 * 1024) // Rozmiar stosu dotykanego przed pętlą busy-poll
+
+// Osobne gniazdo na sondy aktywności (REQUEST) na porcie serwera + LIVENESS_PORT_OFFSET.
+// Zalew PINGów zapełnia kolejkę gniazda danych i jądro odrzuca datagramy jeszcze przed
+// odbiorem, więc kontrola przyjęć w partii nie uratuje REQUEST ze wspólnej kolejki.
+// Port jest ogłaszany w HELLO ("h<id>:<port>"), 0 = REQUEST na porcie danych jak dawniej
+#ifndef LIVENESS_PORT_OFFSET
+#define LIVENESS_PORT_OFFSET 1000
+#endif
 
 // Definicje nagłówków komunikatów
 #define HELLO 'h'    // Nagłówek wiadomości identyfikacyjnej serwera
@@ -18,12 +89,127 @@
 #define PONG 'o'     // Nagłówek odpowiedzi na ping
 #define REQUEST 'q'  // Nagłówek sprawdzenia aktywności
 #define RESPONSE 's' // Nagłówek potwierdzenia aktywności
+#define PACKED 'p'   // Nagłówek ramki zbiorczej z kilkoma wiadomościami
+
+// Na ramkę zbiorczą (frame.h) serwer odpowiada ramką zbiorczą z odpowiedziami na wszystkie wiadomości
 
 // Zmienna do pamiętania czy zainicjalizowało się RNG (generator liczb losowych)
 static int seeded = 0;
 // ID serwera które jest podawane jako parametr przy wywołaniu programu
 static int SERVER_ID;
 
+// Partia datagramów odbieranych jednym recvmmsg() - statyczna, bez alokacji w pętli.
+// Bufory mają rozmiar GRO_BUFFER_SIZE, ale bez GRO odbierane jest najwyżej BUFFER_SIZE bajtów.
+// Zapas PARSE_PADDING pozwala walidacji czytać pełne bloki wektorowe za końcem danych
+struct RecvBatch {
+    char buffers[RECV_BATCH][GRO_BUFFER_SIZE + PARSE_PADDING];
+    struct sockaddr_in senders[RECV_BATCH];
+    // Miejsce na komunikaty kontrolne SO_RXQ_OVFL (licznik zgubionych pakietów)
+    // i UDP_GRO (rozmiar segmentu)
+    char control[RECV_BATCH][UDP_DROPS_CONTROL_SIZE + CMSG_SPACE(sizeof(int))];
+    struct iovec iovecs[RECV_BATCH];
+    struct mmsghdr msgs[RECV_BATCH];
+};
+static struct RecvBatch recv_batch;
+
+// Pojedynczy datagram w partii - po rozdzieleniu buforów GRO na segmenty
+struct Segment {
+    char* data;                 // Początek segmentu w buforze partii
+    int length;                 // Długość segmentu
+    int msg_index;              // Indeks bufora w recv_batch (nadawca, koniec bufora)
+    char type;                  // Nagłówek po walidacji (parse_classify) albo 0 - niepoprawny
+};
+static struct Segment segments[MAX_SEGMENTS];
+
+// Czy gniazdo odbiera połączone datagramy (UDP_GRO przyjęte przez jądro)
+static int gro_enabled = 0;
+
+// Gniazdo sond aktywności i jego port (-1 / 0 = wyłączone, REQUEST na gnieździe danych)
+static int liveness_socket = -1;
+static int liveness_port = 0;
+
+// Statystyki przeciążenia
+struct OverloadStats {
+    uint32_t data_drops;        // Ostatnia wartość SO_RXQ_OVFL gniazda danych (skumulowana)
+    uint32_t liveness_drops;    // Ostatnia wartość SO_RXQ_OVFL gniazda aktywności - jądro liczy osobno
+    unsigned long kernel_drops; // Pakiety odrzucone przez jądro na obu gniazdach
+    unsigned long shed_pings;   // Liczba PINGów odrzuconych przez kontrolę przyjęć
+    unsigned long malformed;    // Liczba odrzuconych niepoprawnych datagramów
+} overload_stats = {0, 0, 0, 0, 0};
+
+// Pula buforów na wiadomości z nagłówkiem (add_header, process_header)
+static struct Pool packet_pool;
+
+// Konfiguracja w czasie działania (plik SERVER_CONFIG_PATH, przeładowanie po SIGHUP).
+// Stałe powyżej są wartościami domyślnymi; pojemności tablic (RECV_BATCH, BUFFER_SIZE)
+// i tryb BUSY_POLL pozostają stałymi kompilacji
+struct ServerConfig {
+    char client_ip[INET_ADDRSTRLEN];    // Adres klienta, do którego idą HELLO
+    int client_port;                    // Port klienta
+    int hello_interval;                 // Okres wysyłania HELLO (sekundy)
+    int recv_batch;                     // Datagramy odbierane jednym recvmmsg() (do RECV_BATCH)
+    int socket_rcvbuf;                  // SO_RCVBUF, 0 = domyślna wartość jądra
+    int socket_sndbuf;                  // SO_SNDBUF, 0 = domyślna wartość jądra
+    int admission_overload_batch;       // Partia, od której działa kontrola przyjęć
+    int admission_ping_budget;          // PINGi obsługiwane w przeciążonej partii
+    int busy_poll_usec;                 // SO_BUSY_POLL (tylko w trybie BUSY_POLL)
+    int busy_poll_idle_ms;              // Budżet bezczynności busy-poll
+    int liveness_port_offset;           // Port gniazda REQUEST względem portu serwera (tylko przy starcie)
+};
+
+static const struct ServerConfig config_defaults = {
+    .client_ip = CLIENT_IP,
+    .client_port = CLIENT_PORT,
+    .hello_interval = HELLO_INTERVAL,
+    .recv_batch = RECV_BATCH,
+    .socket_rcvbuf = SOCKET_RCVBUF,
+    .socket_sndbuf = SOCKET_SNDBUF,
+    .admission_overload_batch = ADMISSION_OVERLOAD_BATCH,
+    .admission_ping_budget = ADMISSION_PING_BUDGET,
+    .busy_poll_usec = BUSY_POLL_USEC,
+    .busy_poll_idle_ms = BUSY_POLL_IDLE_MS,
+    .liveness_port_offset = LIVENESS_PORT_OFFSET,
+};
+
+static const struct ConfigOption config_options[] = {
+    {"client_ip", CONFIG_STRING, offsetof(struct ServerConfig, client_ip), 0, INET_ADDRSTRLEN, 1},
+    {"client_port", CONFIG_INT, offsetof(struct ServerConfig, client_port), 1, 65535, 1},
+    {"hello_interval", CONFIG_INT, offsetof(struct ServerConfig, hello_interval), 1, 3600, 1},
+    {"recv_batch", CONFIG_INT, offsetof(struct ServerConfig, recv_batch), 1, RECV_BATCH, 1},
+    {"socket_rcvbuf", CONFIG_INT, offsetof(struct ServerConfig, socket_rcvbuf), 0, 1 << 30, 1},
+    {"socket_sndbuf", CONFIG_INT, offsetof(struct ServerConfig, socket_sndbuf), 0, 1 << 30, 1},
+    {"admission_overload_batch", CONFIG_INT, offsetof(struct ServerConfig, admission_overload_batch), 1, 1 << 20, 1},
+    {"admission_ping_budget", CONFIG_INT, offsetof(struct ServerConfig, admission_ping_budget), 0, 1 << 20, 1},
+    {"busy_poll_usec", CONFIG_INT, offsetof(struct ServerConfig, busy_poll_usec), 0, 1000000, 1},
+    {"busy_poll_idle_ms", CONFIG_INT, offsetof(struct ServerConfig, busy_poll_idle_ms), 0, 60000, 1},
+    {"liveness_port_offset", CONFIG_INT, offsetof(struct ServerConfig, liveness_port_offset), 0, 65535, 0},
+};
+
+// Funkcja sprawdzająca wczytaną konfigurację (adres klienta musi być poprawnym IPv4)
+static int validate_config(const void* config) {
+    const struct ServerConfig* server_config = config;
+    struct in_addr address;
+    if (inet_pton(AF_INET, server_config->client_ip, &address) <= 0) {
+        printf("\033[31mclient_ip: nieprawidłowy adres IPv4 '%s'\033[0m\n", server_config->client_ip);
+        return -1;
+    }
+    return 0;
+}
+
+static struct ConfigSet config_set = {
+    .path = SERVER_CONFIG_PATH,
+    .options = config_options,
+    .option_count = sizeof(config_options) / sizeof(config_options[0]),
+    .defaults = &config_defaults,
+    .size = sizeof(struct ServerConfig),
+    .validate = validate_config,
+};
+
+// Bieżąca konfiguracja - pobierana przy każdym użyciu, bez przechowywania wskaźnika
+static inline const struct ServerConfig* current_config() {
+    return config_current(&config_set);
+}
+
 // Funkcja generująca losową liczbę z zakresu 0-9
 int get_random_number() {
     if (!seeded) {
@@ -81,8 +267,11 @@ char* process_header(char* message) {
     // size_t to typ całkowity bez znaku przeznaczony do reprezentowania rozmiarów
     // używany w funkcjach zarządzania pamięcią i tablicami
     size_t msg_len = strlen(message) - 1;
-    // malloc alokuje pamięć
-    char* new_message = (char*)malloc(msg_len + 1);
+    // Bufor z puli (BUFFER_SIZE bajtów) - zwalniany przez pool_free(&packet_pool, ...)
+    if (msg_len + 1 > packet_pool.object_size) {
+        return NULL;
+    }
+    char* new_message = (char*)pool_alloc(&packet_pool);
     if (new_message == NULL) {
         return NULL;
     }
@@ -102,8 +291,11 @@ char* add_header(char* message, char header) {
     size_t msg_len = strlen(message);
     size_t new_len = msg_len + 2;  // +1 na nagłówek, +1 na terminator null
 
-    // Alokacja pamięci na nowy ciąg znaków
-    char* new_message = (char*)malloc(new_len);
+    // Bufor z puli - zwalniany przez pool_free(&packet_pool, ...)
+    if (new_len > packet_pool.object_size) {
+        return NULL;
+    }
+    char* new_message = (char*)pool_alloc(&packet_pool);
     if (new_message == NULL) {
         return NULL;
     }
@@ -133,13 +325,13 @@ struct sockaddr_in init_client_adress(){
     client_addr.sin_family = AF_INET;
 
     // htons - Konwersja portu na format sieciowy (host to network short)
-    client_addr.sin_port = htons(CLIENT_PORT);
+    client_addr.sin_port = htons(current_config()->client_port);
 
     // inet_pton - Konwersja adresu IP z formatu tekstowego na binarny
     // AF_INET - rodzina adresów IPv4
-    // CLIENT_IP - adres w formie tekstowej
+    // client_ip - adres w formie tekstowej (z konfiguracji)
     // sin_addr - pole struktury na adres binarny
-    if (inet_pton(AF_INET, CLIENT_IP, &client_addr.sin_addr) <= 0) {
+    if (inet_pton(AF_INET, current_config()->client_ip, &client_addr.sin_addr) <= 0) {
         printf("Nieprawidłowy adres IP klienta\n");
         exit(1);
     }
@@ -147,31 +339,27 @@ struct sockaddr_in init_client_adress(){
     return client_addr;
 }
 
-// Funkcja wysyłająca wiadomość HELLO. Wysyła ID które jest zapisywane w kliencie.
+// Funkcja wysyłająca wiadomość HELLO. Wysyła ID które jest zapisywane w kliencie
+// i port gniazda sond aktywności, jeśli jest otwarte.
 void server_hello(int server_socket, struct sockaddr_in client_addr, socklen_t client_len) {
-    char message[10];
-    sprintf(message, "%d", SERVER_ID);
+    char message[24];
+    if (liveness_port > 0) {
+        sprintf(message, "%d:%d", SERVER_ID, liveness_port);
+    } else {
+        sprintf(message, "%d", SERVER_ID);
+    }
     char* message_with_header = add_header(message, HELLO);
 
     printf("\033[34mWysyłanie wiadomości: [%c]%s\033[0m\n",
            HELLO, message);
 
     if (message_with_header != NULL) {
-        // Socket UDP - wysyłanie danych:
-        // server_socket - deskryptor gniazda przez które wysyłamy
-        // message_with_header - wskaźnik na dane do wysłania (nagłówek+wiadomość)
-        // strlen() - długość wysyłanej wiadomości w bajtach
-        // 0 - flagi (brak dodatkowych opcji)
-        // (struct sockaddr*) - rzutowanie adresu na ogólną strukturę sockaddr
-        // sizeof - rozmiar struktury z adresem odbiorcy w bajtach
-        sendto(server_socket,
-               message_with_header,
-               strlen(message_with_header),
-               0,
-               (struct sockaddr*)&client_addr,
-               sizeof(client_addr));
-    }
-    free(message_with_header);
+        send_datagram(server_socket,
+                      message_with_header,
+                      strlen(message_with_header),
+                      &client_addr);
+    }
+    pool_free(&packet_pool, message_with_header);
 }
 
 // Funkcja obsługująca odpowiedź na PING
@@ -187,9 +375,10 @@ void ping_response(int server_socket, struct sockaddr_in client_addr, socklen_t
                            &client_len);
 
     if (recv_len > 0) {
-        char* recived_message = process_header(buffer);
-
+        capture_record(CAPTURE_IN, &client_addr, buffer, recv_len);
         buffer[recv_len] = '\0';
+        char* recived_message = process_header(buffer);
+        pool_free(&packet_pool, recived_message);  // Treść nie jest dalej potrzebna
         printf("Otrzymano: %s\n", buffer);
 
         char temp_buffer[recv_len+2];
@@ -205,83 +394,499 @@ void ping_response(int server_socket, struct sockaddr_in client_addr, socklen_t
         }
 
         printf("\033[34mWysyłanie: %s \033[0m\n", new_buffer);
-        sendto(server_socket,
-              new_buffer,
-              strlen(new_buffer),
-              0,
-              (struct sockaddr*)&client_addr,
-              client_len);
+        send_datagram(server_socket, new_buffer, strlen(new_buffer), &client_addr);
+
+        pool_free(&packet_pool, new_buffer);
+    }
+}
+
+// Funkcja decydująca, czy obsłużyć PING w ramach budżetu partii
+// ping_budget - pozostała liczba PINGów do obsłużenia, -1 = bez limitu
+// Zwraca 1 gdy PING ma być obsłużony, 0 gdy zostaje pominięty (i jest liczony)
+int admit_ping(int* ping_budget) {
+    if (*ping_budget < 0) {
+        return 1;
+    }
+    if (*ping_budget == 0) {
+        overload_stats.shed_pings++;
+        return 0;
+    }
+    (*ping_budget)--;
+    return 1;
+}
+
+// Funkcja budująca odpowiedź na pojedynczą wiadomość
+// message - wiadomość z nagłówkiem zakończona znakiem null, length - jej długość
+// reply - bufor na odpowiedź o rozmiarze co najmniej length + 2
+// Zwraca długość odpowiedzi albo 0, gdy wiadomość nie wymaga odpowiedzi
+int build_reply(const char* message, int length, char* reply) {
+    char header = message[0];
+
+    printf("\033[35mOtrzymano wiadomość: [%c]%s\033[0m\n",
+           header, message + 1);
+
+    switch(header) {
+        case PING: {
+            printf("\033[32mOtrzymano PING\033[0m\n");
+            // PONG = nagłówek + losowa cyfra + treść PINGa
+            reply[0] = PONG;
+            // konwersja liczby na znak ASCII przez dodanie do kodu znaku '0'
+            reply[1] = '0' + get_random_number();
+            memcpy(reply + 2, message + 1, length - 1);
+            reply[length + 1] = '\0';
+            printf("\033[34mWysyłanie PONG: [%c]%s\033[0m\n", PONG, reply + 1);
+            return length + 1;
+        }
+
+        case REQUEST: {
+            printf("\033[32mOtrzymano żądanie sprawdzenia aktywności\033[0m\n");
+            // Odpowiedź odsyła epokę z żądania ("q42" -> "s42"), aby klient mógł
+            // dopasować ją do rundy; samo "q" dostaje samo "s"
+            reply[0] = RESPONSE;
+            memcpy(reply + 1, message + 1, length - 1);
+            reply[length] = '\0';
+            printf("\033[34mWysyłanie odpowiedzi: %s\033[0m\n", reply);
+            return length;
+        }
+
+        default: {
+            printf("\033[31mNieznany typ wiadomości: %c\033[0m\n", header);
+            return 0;
+        }
+    }
+}
 
-        free(new_buffer);
+// Funkcja obsługująca ramkę zbiorczą - odpowiedzi na wszystkie wiadomości
+// wracają w jednej ramce (albo w kilku, jeśli nie zmieszczą się w PACK_MTU)
+void process_packed_frame(int server_socket, const char* buffer, int recv_len,
+                          struct sockaddr_in* client_addr, int* ping_budget) {
+    struct PackedFrame reply_frame;
+    frame_init(&reply_frame);
+
+    int offset = 1;
+    const char* packed;
+    int length;
+    int result;
+    while ((result = frame_next(buffer, recv_len, &offset, &packed, &length)) > 0) {
+        char message[PACK_MAX_MESSAGE + 1];
+        memcpy(message, packed, length);
+        message[length] = '\0';
+
+        if (message[0] == PING && !admit_ping(ping_budget)) {
+            continue;
+        }
+
+        char reply[PACK_MAX_MESSAGE + 2];
+        int reply_len = build_reply(message, length, reply);
+        if (reply_len == 0) {
+            continue;
+        }
+        if (!frame_append(&reply_frame, reply, reply_len)) {
+            frame_send(server_socket, &reply_frame, client_addr);
+            if (!frame_append(&reply_frame, reply, reply_len)) {
+                // Odpowiedź dłuższa niż PACK_MAX_MESSAGE - osobny datagram
+                send_datagram(server_socket, reply, reply_len, client_addr);
+            }
+        }
+    }
+    if (result < 0) {
+        printf("\033[31mUszkodzona ramka zbiorcza\033[0m\n");
+    }
+
+    frame_send(server_socket, &reply_frame, client_addr);
+}
+
+// Funkcja przetwarzająca pojedynczy odebrany datagram i wysyłająca odpowiedź
+// buffer musi mieć miejsce na terminator null za recv_len bajtami
+// ping_budget - budżet PINGów partii (patrz admit_ping)
+void process_message(int server_socket, char* buffer, int recv_len,
+                     struct sockaddr_in* client_addr, int* ping_budget) {
+    // Dodanie terminatora null po ostatnim znaku odebranej wiadomości
+    buffer[recv_len] = '\0';
+
+    if (buffer[0] == PACKED) {
+        process_packed_frame(server_socket, buffer, recv_len, client_addr, ping_budget);
+        return;
+    }
+    if (buffer[0] == PING && !admit_ping(ping_budget)) {
+        return;
+    }
+
+    char reply[BUFFER_SIZE + 2];
+    int reply_len = build_reply(buffer, recv_len, reply);
+    if (reply_len > 0) {
+        send_datagram(server_socket, reply, reply_len, client_addr);
+    }
+}
+
+// Funkcja ustawiająca bufory gniazda z konfiguracji (po przeładowaniu)
+void apply_socket_buffers(int sock) {
+    udp_set_buffers(sock, current_config()->socket_rcvbuf, current_config()->socket_sndbuf);
+}
+
+// Funkcja ustawiająca bufory gniazda, włączająca licznik zgubionych pakietów i UDP GRO
+void configure_socket(int sock) {
+    udp_configure(sock, current_config()->socket_rcvbuf, current_config()->socket_sndbuf);
+
+    // UDP_GRO - starsze jądra (< 5.0) zwracają ENOPROTOOPT, wtedy odbiór pojedynczo
+    if (USE_UDP_GRO) {
+        int enable = 1;
+        if (setsockopt(sock, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == 0) {
+            gro_enabled = 1;
+        } else {
+            perror("Ostrzeżenie: UDP_GRO niedostępne");
+        }
+    }
+    printf("UDP GRO: %s\n", gro_enabled ? "tak" : "nie");
+}
+
+// Funkcja odbierająca partię datagramów do recv_batch
+// flags - MSG_DONTWAIT dla odbioru nieblokującego
+// Zwraca liczbę odebranych datagramów albo -1 przy błędzie (errno ustawione)
+int receive_batch(int server_socket, int flags) {
+    int batch = current_config()->recv_batch;
+
+    // msg_namelen i msg_controllen są nadpisywane przez jądro, więc trzeba je ustawiać co wywołanie
+    for (int i = 0; i < batch; i++) {
+        // - 1, aby zostało miejsce na terminator null
+        recv_batch.iovecs[i].iov_base = recv_batch.buffers[i];
+        recv_batch.iovecs[i].iov_len = (gro_enabled ? GRO_BUFFER_SIZE : BUFFER_SIZE) - 1;
+        memset(&recv_batch.msgs[i], 0, sizeof(recv_batch.msgs[i]));
+        recv_batch.msgs[i].msg_hdr.msg_iov = &recv_batch.iovecs[i];
+        recv_batch.msgs[i].msg_hdr.msg_iovlen = 1;
+        recv_batch.msgs[i].msg_hdr.msg_name = &recv_batch.senders[i];
+        recv_batch.msgs[i].msg_hdr.msg_namelen = sizeof(recv_batch.senders[i]);
+        recv_batch.msgs[i].msg_hdr.msg_control = recv_batch.control[i];
+        recv_batch.msgs[i].msg_hdr.msg_controllen = sizeof(recv_batch.control[i]);
+    }
+
+    return recvmmsg(server_socket, recv_batch.msgs, batch, flags, NULL);
+}
+
+// Funkcja sprawdzająca licznik SO_RXQ_OVFL w partii odebranej z gniazda server_socket
+// Licznik jest osobny dla każdego gniazda, więc porównywany z ostatnią wartością tego gniazda
+// Zwraca liczbę pakietów zgubionych przez jądro od poprzedniego sprawdzenia
+uint32_t check_kernel_drops(int server_socket, int count) {
+    uint32_t* seen = server_socket == liveness_socket ? &overload_stats.liveness_drops
+                                                      : &overload_stats.data_drops;
+    uint32_t latest = *seen;
+
+    for (int i = 0; i < count; i++) {
+        udp_drop_counter(&recv_batch.msgs[i].msg_hdr, &latest);
+    }
+
+    uint32_t new_drops = latest - *seen;
+    *seen = latest;
+    overload_stats.kernel_drops += new_drops;
+    return new_drops;
+}
+
+// Funkcja odczytująca rozmiar segmentu UDP_GRO z komunikatów kontrolnych
+// Zwraca rozmiar segmentu albo 0, gdy bufor zawiera jeden datagram
+int gro_segment_size(struct msghdr* hdr) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int segment_size;
+            memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+            return segment_size;
+        }
+    }
+    return 0;
+}
+
+// Funkcja dzieląca bufory partii na pojedyncze datagramy (segmenty GRO)
+// Zwraca liczbę segmentów zapisanych w tablicy segments
+int split_segments(int count) {
+    int segment_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        int length = recv_batch.msgs[i].msg_len;
+        int segment_size = gro_segment_size(&recv_batch.msgs[i].msg_hdr);
+        if (segment_size <= 0 || segment_size > length) {
+            segment_size = length;
+        }
+
+        for (int offset = 0; offset < length && segment_count < MAX_SEGMENTS; offset += segment_size) {
+            segments[segment_count].data = recv_batch.buffers[i] + offset;
+            segments[segment_count].length =
+                length - offset < segment_size ? length - offset : segment_size;
+            segments[segment_count].msg_index = i;
+            segment_count++;
+        }
+    }
+
+    return segment_count;
+}
+
+// Funkcja przetwarzająca jeden segment
+// process_message dopisuje terminator null za wiadomością, więc segment ze środka
+// bufora GRO (za którym leży następny segment) jest najpierw kopiowany.
+// Segmenty dłuższe niż BUFFER_SIZE - 1 są obcinane, tak jak przy odbiorze bez GRO
+void process_segment(int server_socket, struct Segment* segment, int* ping_budget) {
+    char* buffer_end = recv_batch.buffers[segment->msg_index] + recv_batch.msgs[segment->msg_index].msg_len;
+    struct sockaddr_in* sender = &recv_batch.senders[segment->msg_index];
+
+    if (segment->data + segment->length == buffer_end && segment->length < BUFFER_SIZE) {
+        process_message(server_socket, segment->data, segment->length, sender, ping_budget);
+        return;
+    }
+
+    char copy[BUFFER_SIZE + PARSE_PADDING];
+    int length = segment->length < BUFFER_SIZE - 1 ? segment->length : BUFFER_SIZE - 1;
+    memcpy(copy, segment->data, length);
+    process_message(server_socket, copy, length, sender, ping_budget);
+}
+
+// Funkcja przetwarzająca partię z kontrolą przyjęć.
+// Najpierw obsługiwane są wiadomości inne niż PING (REQUEST - wykrywanie awarii),
+// potem PINGi - przy przeciążeniu tylko ADMISSION_PING_BUDGET z nich.
+void process_batch(int server_socket, int count) {
+    uint32_t new_drops = check_kernel_drops(server_socket, count);
+    int segment_count = split_segments(count);
+
+    // Zapis ruchu obejmuje wszystkie odebrane datagramy, także te pominięte niżej
+    for (int i = 0; i < segment_count; i++) {
+        capture_record(CAPTURE_IN,
+                       &recv_batch.senders[segments[i].msg_index],
+                       segments[i].data,
+                       segments[i].length);
+    }
+
+    // Walidacja i klasyfikacja całej partii przed obsługą - niepoprawne datagramy
+    // (nieznany nagłówek, zła treść, uszkodzona ramka zbiorcza) są od razu odrzucane
+    int malformed = 0;
+    for (int i = 0; i < segment_count; i++) {
+        segments[i].type = parse_classify(segments[i].data, segments[i].length);
+        if (segments[i].type == 0) {
+            malformed++;
+        }
+    }
+    if (malformed > 0) {
+        overload_stats.malformed += malformed;
+        printf("\033[31mOdrzucono %d niepoprawnych datagramów (łącznie %lu)\033[0m\n",
+               malformed, overload_stats.malformed);
+    }
+
+    int overloaded = segment_count >= current_config()->admission_overload_batch || new_drops > 0;
+    int ping_budget = overloaded ? current_config()->admission_ping_budget : -1;
+    unsigned long shed_before = overload_stats.shed_pings;
+
+    if (new_drops > 0) {
+        printf("\033[31mJądro odrzuciło %u pakietów%s (łącznie %lu) - pełny bufor odbiorczy\033[0m\n",
+               new_drops, server_socket == liveness_socket ? " sond aktywności" : "",
+               overload_stats.kernel_drops);
+    }
+
+    // Pierwsze przejście - wiadomości priorytetowe (i ramki zbiorcze,
+    // w których PINGi też podlegają budżetowi)
+    for (int i = 0; i < segment_count; i++) {
+        if (segments[i].type != 0 && segments[i].type != PING) {
+            process_segment(server_socket, &segments[i], &ping_budget);
+        }
+    }
+
+    // Drugie przejście - PINGi, przy przeciążeniu ograniczone budżetem
+    for (int i = 0; i < segment_count; i++) {
+        if (segments[i].type == PING) {
+            process_segment(server_socket, &segments[i], &ping_budget);
+        }
+    }
+
+    unsigned long shed = overload_stats.shed_pings - shed_before;
+    if (shed > 0) {
+        printf("\033[33mPrzeciążenie: pominięto %lu PING (łącznie %lu)\033[0m\n",
+               shed, overload_stats.shed_pings);
     }
 }
 
 // Główna funkcja obsługująca przychodzące wiadomości
-void handle_message(int server_socket, struct sockaddr_in client_addr, socklen_t client_len) {
-    char buffer[BUFFER_SIZE];
+// Wywoływana gdy select() zgłosi dane - odbiera wszystko co czeka w kolejce (do recv_batch).
+// Odpowiedzi wychodzą przez to samo gniazdo, więc RESPONSE z gniazda aktywności
+// ma port nadawcy równy portowi aktywności
+void handle_message(int server_socket) {
+    int count = receive_batch(server_socket, MSG_DONTWAIT);
+
+    if (count > 0) {
+        process_batch(server_socket, count);
+    }
+}
 
-    int recv_len = recvfrom(server_socket,
-                           buffer,
-                           BUFFER_SIZE,
-                           0,
-                           (struct sockaddr*)&client_addr,
-                           &client_len);
+// Funkcja wysyłająca HELLO, jeśli od ostatniego minęło hello_interval sekund
+void send_periodic_hello(int server_socket, struct sockaddr_in client_addr, socklen_t client_len,
+                         time_t* last_hello_time) {
+    time_t current_time = time(NULL);
+    if (current_time - *last_hello_time >= current_config()->hello_interval) {
+        server_hello(server_socket, client_addr, client_len);
+        *last_hello_time = current_time;
+    }
+}
 
-    if (recv_len > 0) {
-        // Dodanie terminatora null po ostatnim znaku odebranej wiadomości
-        buffer[recv_len] = '\0';
-        // wstawienie headera na pierwszy znak
-        char header = buffer[0];
-
-        printf("\033[35mOtrzymano wiadomość: [%c]%s\033[0m\n",
-               header, buffer + 1);
-
-        switch(header) {
-            case PING: {
-                printf("\033[32mOtrzymano PING\033[0m\n");
-                char temp_buffer[recv_len + 2];
-                int random_number = get_random_number();
-                temp_buffer[0] = '0' + random_number;
-                strcpy(temp_buffer + 1, buffer + 1);
-
-                char* pong_msg = add_header(temp_buffer, PONG);
-                if (pong_msg != NULL) {
-                    printf("\033[34mWysyłanie PONG: [%c]%s\033[0m\n", PONG, temp_buffer);
-                    sendto(server_socket,
-                           pong_msg,
-                           strlen(pong_msg),
-                           0,
-                           (struct sockaddr*)&client_addr,
-                           client_len);
-                    free(pong_msg);
-                }
-                break;
+// Funkcja zwracająca czas monotoniczny w milisekundach
+// (niezależny od zmian zegara systemowego)
+long long monotonic_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Funkcja dotykająca strony stosu, aby pętla busy-poll nie trafiała na page faulty
+void prefault_stack() {
+    char stack[PREFAULT_STACK_SIZE];
+    memset(stack, 0, sizeof(stack));
+    // Bariera - adres tablicy "ucieka" do asm, więc kompilator nie może
+    // usunąć memset() ani zmniejszyć ramki stosu
+    __asm__ volatile("" : : "r"(stack) : "memory");
+}
+
+// Funkcja ustawiająca SO_BUSY_POLL na gnieździe danych i gnieździe sond aktywności -
+// jądro odpytuje kolejkę sterownika zamiast czekać na przerwanie
+// (wartości powyżej net.core.busy_read wymagają CAP_NET_ADMIN)
+void apply_busy_poll(int server_socket) {
+    int busy_poll_usec = current_config()->busy_poll_usec;
+    if (setsockopt(server_socket, SOL_SOCKET, SO_BUSY_POLL,
+                   &busy_poll_usec, sizeof(busy_poll_usec)) < 0) {
+        perror("Ostrzeżenie: SO_BUSY_POLL");
+    }
+    if (liveness_socket >= 0 &&
+        setsockopt(liveness_socket, SOL_SOCKET, SO_BUSY_POLL,
+                   &busy_poll_usec, sizeof(busy_poll_usec)) < 0) {
+        perror("Ostrzeżenie: SO_BUSY_POLL (gniazdo aktywności)");
+    }
+}
+
+// Przygotowanie procesu do trybu busy-poll: SO_BUSY_POLL na gniazdach,
+// przypięcie do rdzenia i zablokowanie pamięci w RAM.
+// Błędy nie są krytyczne - serwer działa dalej bez danej optymalizacji.
+void busy_poll_setup(int server_socket) {
+    apply_busy_poll(server_socket);
+
+    // Przypięcie do rdzenia - brak migracji między CPU i zimnych cache
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(BUSY_POLL_CPU, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+        perror("Ostrzeżenie: sched_setaffinity");
+    }
+
+    // MCL_CURRENT - obecne strony, MCL_FUTURE - także przyszłe alokacje
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        perror("Ostrzeżenie: mlockall");
+    }
+    prefault_stack();
+
+    printf("\033[33mTryb busy-poll: CPU %d, SO_BUSY_POLL %d us, budżet bezczynności %d ms\033[0m\n",
+           BUSY_POLL_CPU, current_config()->busy_poll_usec, current_config()->busy_poll_idle_ms);
+}
+
+// Funkcja stosująca przeładowaną konfigurację (wywoływana w pętli głównej po SIGHUP).
+// Pozostałe klucze działają od następnego użycia - są czytane przez current_config()
+void apply_config_reload(int server_socket, struct sockaddr_in* client_addr) {
+    if (!config_poll(&config_set)) {
+        return;
+    }
+
+    apply_socket_buffers(server_socket);
+    if (liveness_socket >= 0) {
+        apply_socket_buffers(liveness_socket);
+    }
+    *client_addr = init_client_adress();
+    if (BUSY_POLL) {
+        apply_busy_poll(server_socket);
+    }
+}
+
+// Pętla busy-poll: nieblokujące recvmmsg() w kółko, bez usypiania w select().
+// Po busy_poll_idle_ms bez żadnego pakietu serwer wraca do blokującego select(),
+// a po pierwszym pakiecie znów zaczyna aktywne odpytywanie.
+void busy_poll_loop(int server_socket, struct sockaddr_in client_addr, socklen_t client_len) {
+    time_t last_hello_time = time(NULL);
+    long long last_packet_ms = monotonic_ms();
+
+    while (!shutdown_requested()) {
+        // Sondy aktywności przed danymi - kolejka gniazda aktywności jest krótka
+        if (liveness_socket >= 0) {
+            int liveness_count = receive_batch(liveness_socket, MSG_DONTWAIT);
+            if (liveness_count > 0) {
+                process_batch(liveness_socket, liveness_count);
+                last_packet_ms = monotonic_ms();
             }
+        }
 
-            case REQUEST: {
-                printf("\033[32mOtrzymano żądanie sprawdzenia aktywności\033[0m\n");
-                char response = RESPONSE;
-                printf("\033[34mWysyłanie odpowiedzi: [%c]\033[0m\n", response);
-                sendto(server_socket,
-                       &response,
-                       1,
-                       0,
-                       (struct sockaddr*)&client_addr,
-                       client_len);
-                break;
+        int count = receive_batch(server_socket, MSG_DONTWAIT);
+
+        if (count > 0) {
+            process_batch(server_socket, count);
+            last_packet_ms = monotonic_ms();
+        } else if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            perror("Błąd recvmmsg");
+            break;
+        } else if (monotonic_ms() - last_packet_ms >= current_config()->busy_poll_idle_ms) {
+            // Budżet bezczynności wyczerpany - blokujące czekanie jak w zwykłej pętli
+            fd_set readfds;
+            struct timeval tv;
+            FD_ZERO(&readfds);
+            FD_SET(server_socket, &readfds);
+            if (liveness_socket >= 0) {
+                FD_SET(liveness_socket, &readfds);
             }
+            tv.tv_sec = 0;
+            tv.tv_usec = 100000;  // 100ms timeout
 
-            default: {
-                printf("\033[31mNieznany typ wiadomości: %c\033[0m\n", header);
+            int max_fd = liveness_socket > server_socket ? liveness_socket : server_socket;
+            int activity = select(max_fd + 1, &readfds, NULL, NULL, &tv);
+            if (activity < 0 && errno != EINTR) {
+                printf("Błąd select");
                 break;
             }
+            if (activity > 0) {
+                last_packet_ms = monotonic_ms();
+            }
         }
+
+        apply_config_reload(server_socket, &client_addr);
+        if (report_requested()) {
+            pool_report(&packet_pool);
+        }
+        send_periodic_hello(server_socket, client_addr, client_len, &last_hello_time);
+    }
+}
+
+// Funkcja otwierająca gniazdo sond aktywności na porcie server_port + liveness_port_offset.
+// Błąd nie jest krytyczny - REQUEST trafiają wtedy na gniazdo danych (HELLO bez portu)
+void open_liveness_socket(int server_port) {
+    int offset = current_config()->liveness_port_offset;
+    if (offset == 0) {
+        return;
+    }
+    int port = server_port + offset;
+    if (port > 65535) {
+        printf("\033[33mOstrzeżenie: port aktywności %d poza zakresem - REQUEST na porcie danych\033[0m\n", port);
+        return;
     }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    configure_socket(sock);
+
+    struct sockaddr_in liveness_addr;
+    memset(&liveness_addr, 0, sizeof(liveness_addr));
+    liveness_addr.sin_family = AF_INET;
+    liveness_addr.sin_addr.s_addr = INADDR_ANY;
+    liveness_addr.sin_port = htons(port);
+
+    if (bind(sock, (struct sockaddr*)&liveness_addr, sizeof(liveness_addr)) < 0) {
+        perror("Ostrzeżenie: bind gniazda aktywności - REQUEST na porcie danych");
+        close(sock);
+        return;
+    }
+
+    liveness_socket = sock;
+    liveness_port = port;
+    printf("Gniazdo sond aktywności: port %d\n", liveness_port);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        printf("Użycie: %s <port> <id_serwera>\n", argv[0]);
+    if (argc != 3 && argc != 4) {
+        printf("Użycie: %s <port> <id_serwera> [plik_zapisu_ruchu]\n", argv[0]);
         printf("Przykład: %s 1306 1337\n", argv[0]);
         return 1;
     }
@@ -290,8 +895,26 @@ int main(int argc, char *argv[]) {
     SERVER_ID = atoi(argv[2]);
 
     printf("Uruchamianie serwera na porcie %d z ID %d\n", server_port, SERVER_ID);
+
+    // Opcjonalny zapis całego ruchu do pliku (do odtworzenia programem replay)
+    if (argc == 4 && capture_open(argv[3], CAPTURE_ROLE_SERVER) < 0) {
+        exit(1);
+    }
     print_protocol_headers();
 
+    if (config_init(&config_set) < 0) {
+        exit(1);
+    }
+    config_print(&config_set);
+    signals_init();
+
+    parse_init();
+    printf("Walidacja wiadomości: %s\n", parse_implementation());
+
+    if (pool_init(&packet_pool, "wiadomości", BUFFER_SIZE, PACKET_POOL_SLAB) < 0) {
+        exit(1);
+    }
+
     int server_socket;
     struct sockaddr_in server_addr, client_addr;
     char buffer[BUFFER_SIZE];
@@ -299,6 +922,7 @@ int main(int argc, char *argv[]) {
 
     // Utworzenie gniazda UDP
     server_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    configure_socket(server_socket);
 
     // Konfiguracja adresu serwera
     memset(&server_addr, 0, sizeof(server_addr));
@@ -313,44 +937,78 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
+    open_liveness_socket(server_port);
+
     client_addr = init_client_adress();
 
     printf("Serwer uruchomiony. Wysyłanie początkowej wiadomości HELLO...\n");
     sleep(1);
     server_hello(server_socket, client_addr, client_len);
 
+    if (BUSY_POLL) {
+        busy_poll_setup(server_socket);
+        busy_poll_loop(server_socket, client_addr, client_len);
+        printf("Zamykanie serwera\n");
+        pool_destroy(&packet_pool);
+        config_destroy(&config_set);
+        capture_close();
+        close(server_socket);
+        if (liveness_socket >= 0) {
+            close(liveness_socket);
+        }
+        return 0;
+    }
+
     // Zmienne dla select()
     fd_set readfds;
     struct timeval tv;
     time_t last_hello_time = time(NULL);
 
-    while (1) {
+    int max_fd = liveness_socket > server_socket ? liveness_socket : server_socket;
+
+    while (!shutdown_requested()) {
         FD_ZERO(&readfds);
         FD_SET(server_socket, &readfds);
+        if (liveness_socket >= 0) {
+            FD_SET(liveness_socket, &readfds);
+        }
 
         tv.tv_sec = 0;
         tv.tv_usec = 100000;  // 100ms timeout
 
-        int activity = select(server_socket + 1, &readfds, NULL, NULL, &tv);
+        int activity = select(max_fd + 1, &readfds, NULL, NULL, &tv);
 
-        if (activity < 0) {
+        // EINTR - select() przerwany sygnałem (np. SIGHUP przeładowania konfiguracji)
+        if (activity < 0 && errno != EINTR) {
             printf("Błąd select");
             break;
         }
 
-        // Wysyłanie okresowych wiadomości HELLO
-        time_t current_time = time(NULL);
-        if (current_time - last_hello_time >= 5) {
-            server_hello(server_socket, client_addr, client_len);
-            last_hello_time = current_time;
+        // Przeładowanie konfiguracji i raport puli (SIGUSR1) między partiami pakietów
+        apply_config_reload(server_socket, &client_addr);
+        if (report_requested()) {
+            pool_report(&packet_pool);
         }
 
-        // Obsługa przychodzących danych
-        if (FD_ISSET(server_socket, &readfds)) {
-            handle_message(server_socket, client_addr, client_len);
+        // Wysyłanie okresowych wiadomości HELLO
+        send_periodic_hello(server_socket, client_addr, client_len, &last_hello_time);
+
+        // Obsługa przychodzących danych - sondy aktywności przed danymi
+        if (activity > 0 && liveness_socket >= 0 && FD_ISSET(liveness_socket, &readfds)) {
+            handle_message(liveness_socket);
+        }
+        if (activity > 0 && FD_ISSET(server_socket, &readfds)) {
+            handle_message(server_socket);
         }
     }
 
+    printf("Zamykanie serwera\n");
+    pool_destroy(&packet_pool);
+    config_destroy(&config_set);
+    capture_close();
     close(server_socket);
+    if (liveness_socket >= 0) {
+        close(liveness_socket);
+    }
     return 0;
 }
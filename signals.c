@@ -0,0 +1,48 @@
+#include "signals.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+
+static volatile sig_atomic_t shutdown_flag = 0;
+static volatile sig_atomic_t report_flag = 0;
+
+static void shutdown_signal_handler(int signal_number) {
+    (void)signal_number;
+    shutdown_flag = 1;
+}
+
+static void report_signal_handler(int signal_number) {
+    (void)signal_number;
+    report_flag = 1;
+}
+
+void signals_init() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = shutdown_signal_handler;
+    action.sa_flags = SA_RESETHAND;    // Bez SA_RESTART - select() wraca z EINTR od razu
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGINT, &action, NULL) < 0 || sigaction(SIGTERM, &action, NULL) < 0) {
+        perror("Ostrzeżenie: SIGINT/SIGTERM");
+    }
+
+    // Raport można zamawiać wielokrotnie - bez SA_RESETHAND
+    action.sa_handler = report_signal_handler;
+    action.sa_flags = 0;
+    if (sigaction(SIGUSR1, &action, NULL) < 0) {
+        perror("Ostrzeżenie: SIGUSR1");
+    }
+}
+
+int shutdown_requested() {
+    return shutdown_flag;
+}
+
+int report_requested() {
+    if (!report_flag) {
+        return 0;
+    }
+    report_flag = 0;
+    return 1;
+}
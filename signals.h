@@ -0,0 +1,21 @@
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+// Zakończenie programu sygnałem SIGINT (Ctrl+C) albo SIGTERM (kill, timeout).
+// Obsługa sygnału tylko ustawia flagę - pętle główne sprawdzają ją w każdej iteracji
+// i kończą się normalnie, więc wykonuje się kod sprzątający (capture_close, snapshot_sync,
+// pool_destroy). Drugi sygnał kończy program od razu (SA_RESETHAND przywraca domyślną obsługę).
+//
+// SIGUSR1 (kill -USR1 <pid>) zamawia raport statystyk puli w trakcie działania -
+// pętla główna wypisuje go w tym samym miejscu, w którym przeładowuje konfigurację.
+
+// Instaluje obsługę SIGINT, SIGTERM i SIGUSR1
+void signals_init();
+
+// Zwraca 1, gdy przyszedł sygnał zakończenia
+int shutdown_requested();
+
+// Zwraca 1 (i kasuje flagę), gdy przyszedł SIGUSR1 od ostatniego sprawdzenia
+int report_requested();
+
+#endif
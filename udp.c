@@ -0,0 +1,61 @@
+#include "udp.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "capture.h"        // Zapis wysłanych datagramów
+
+void udp_set_buffers(int sock, int rcvbuf, int sndbuf) {
+    if (rcvbuf > 0 && setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        perror("Ostrzeżenie: SO_RCVBUF");
+    }
+    if (sndbuf > 0 && setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)) < 0) {
+        perror("Ostrzeżenie: SO_SNDBUF");
+    }
+}
+
+void udp_configure(int sock, int rcvbuf, int sndbuf) {
+    udp_set_buffers(sock, rcvbuf, sndbuf);
+
+    // SO_RXQ_OVFL - jądro dołącza do każdego datagramu licznik pakietów
+    // odrzuconych z powodu pełnego bufora odbiorczego
+    int enable = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) < 0) {
+        perror("Ostrzeżenie: SO_RXQ_OVFL");
+    }
+
+    // Jądro podwaja żądaną wartość, więc wypisujemy faktyczny rozmiar
+    int actual_rcvbuf = 0, actual_sndbuf = 0;
+    socklen_t size_len = sizeof(actual_rcvbuf);
+    getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &actual_rcvbuf, &size_len);
+    size_len = sizeof(actual_sndbuf);
+    getsockopt(sock, SOL_SOCKET, SO_SNDBUF, &actual_sndbuf, &size_len);
+    printf("Bufory gniazda: odbiorczy %d B, nadawczy %d B\n", actual_rcvbuf, actual_sndbuf);
+}
+
+int udp_drop_counter(struct msghdr* hdr, uint32_t* counter) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            memcpy(counter, CMSG_DATA(cmsg), sizeof(*counter));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void send_datagram(int sock, const char* data, size_t length, struct sockaddr_in* addr) {
+    // Socket UDP - wysyłanie danych:
+    // sock - deskryptor gniazda przez które wysyłamy
+    // data - wskaźnik na dane do wysłania (nagłówek+wiadomość)
+    // length - długość wysyłanej wiadomości w bajtach
+    // 0 - flagi (brak dodatkowych opcji)
+    // (struct sockaddr*) - rzutowanie adresu na ogólną strukturę sockaddr
+    // sizeof - rozmiar struktury z adresem odbiorcy w bajtach
+    sendto(sock,
+           data,
+           length,
+           0,
+           (struct sockaddr*)addr,
+           sizeof(*addr));
+    capture_record(CAPTURE_OUT, addr, data, length);
+}
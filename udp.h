@@ -0,0 +1,28 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/socket.h>     // Dla struct msghdr i CMSG_SPACE
+#include <netinet/in.h>     // Dla struct sockaddr_in
+
+// Wspólne operacje na gniazdach UDP serwera i klienta: bufory gniazda, licznik
+// pakietów odrzuconych przez jądro (SO_RXQ_OVFL) i wysyłanie z zapisem ruchu.
+
+// Miejsce na komunikat kontrolny SO_RXQ_OVFL w buforze msg_control
+#define UDP_DROPS_CONTROL_SIZE CMSG_SPACE(sizeof(uint32_t))
+
+// Ustawia SO_RCVBUF i SO_SNDBUF (0 = domyślna wartość jądra, bez zmiany)
+void udp_set_buffers(int sock, int rcvbuf, int sndbuf);
+
+// Ustawia bufory, włącza licznik SO_RXQ_OVFL i wypisuje faktyczne rozmiary buforów
+void udp_configure(int sock, int rcvbuf, int sndbuf);
+
+// Szuka licznika SO_RXQ_OVFL w komunikatach kontrolnych odebranego datagramu.
+// Zwraca 1 i zapisuje skumulowany licznik w counter albo 0, gdy go nie ma
+int udp_drop_counter(struct msghdr* hdr, uint32_t* counter);
+
+// Wysyła datagram i dopisuje go do zapisu ruchu (jeśli włączony)
+void send_datagram(int sock, const char* data, size_t length, struct sockaddr_in* addr);
+
+#endif